@@ -3,980 +3,5969 @@
 #include <vector>
 #include <iterator>
 #include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
 
 #include "biginteger.h"
 
+#ifdef BIGINTEGER_MAPPED_FILES
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+typedef BigInteger::BaseType BaseType;
+typedef BigInteger::DoubleBaseType DoubleBaseType;
+
 //
-// actual functions
+// limb allocators
 //
-BigInteger::BigInteger()
+static thread_local LimbAllocator* currentAllocator = 0;
+
+LimbAllocator* LimbAllocator::current()
 {
-	operator = (0);
+	return currentAllocator ? currentAllocator : &HeapLimbAllocator::instance();
 }
 
-BigInteger::BigInteger(const int& input)
+LimbAllocator* LimbAllocator::setCurrent(LimbAllocator* allocator)
 {
-	operator = (input);
+	LimbAllocator* previous = current();
+	currentAllocator = allocator;
+	return previous;
 }
 
-BigInteger::BigInteger(const std::string& input)
+void* HeapLimbAllocator::allocate(std::size_t bytes)
 {
-	std::string::const_reverse_iterator iterator = input.rbegin(), lastPosition = input.rend();
-
-	// parse the sign from string
-	switch(input[0])
-	{
-		case '-':
-			sign = NEGATIVE;
-			lastPosition -= 1;
-			break;
-		case '0':
-			if(input.length() == 1)
-			{
-				sign = ZERO;
-				return;
-			}
-		default:
-			sign = POSITIVE;
-	}
-
-	// iterate through the characters
-	int counter = 0, newgroup = 0, buffer = 0;
-	for(iterator = input.rbegin(); iterator != lastPosition; ++iterator)
-	{
-		// skip the null character
-		if(*iterator == '\0')
-			continue;
-
-		// push the new group if counter full
-		if(counter == BaseMagnitude10)
-		{
-			storage.push_back(newgroup);
-			counter = newgroup = 0;
-		}
-
-		if(!std::isdigit(*iterator))
-			throw "BigInteger::BigInteger(const std::string&) -> not a digit";
-
-		buffer = (int)(*iterator-'0');
-		for(int i=0; i<counter; i++)
-			buffer *= 10;
-		newgroup += buffer;
+	return ::operator new(bytes);
+}
 
-		// increment counter to advance digits in the group
-		counter++;
-	}
+void HeapLimbAllocator::deallocate(void* block, std::size_t)
+{
+	::operator delete(block);
+}
 
-	// push the remaining result into the storage
-	if(newgroup != 0)
-		storage.push_back(newgroup);
+HeapLimbAllocator& HeapLimbAllocator::instance()
+{
+	static HeapLimbAllocator allocator;
+	return allocator;
 }
 
-BigInteger::BigInteger(const BigInteger& input)
+// blocks are handed out on this boundary, enough for any limb type
+static const std::size_t ArenaAlignment = 16;
+
+static std::size_t alignArena(std::size_t bytes)
 {
-	operator = (input);
+	return (bytes + ArenaAlignment - 1) & ~(ArenaAlignment - 1);
 }
 
-// unary operator
-void BigInteger::operator - ()
+ArenaLimbAllocator::ArenaLimbAllocator(std::size_t chunkBytes) : chunkBytes(alignArena(chunkBytes)), used(0), last(0)
 {
-	if(sign == BigInteger::POSITIVE)
-		sign = BigInteger::NEGATIVE;
-	else if(sign == BigInteger::NEGATIVE)
-		sign = BigInteger::POSITIVE;
 }
 
-BigInteger BigInteger::operator - () const
+ArenaLimbAllocator::~ArenaLimbAllocator()
 {
-	BigInteger result(*this);
-	result.operator - ();
-	return result;
+	for(std::size_t index = 0; index < chunks.size(); index++)
+		::operator delete(chunks[index].begin);
 }
 
-void BigInteger::operator ++ ()
+void* ArenaLimbAllocator::allocate(std::size_t bytes)
 {
-	if(isZero())
-	{
-		// 0 -> 1
-		operator = (1);
-		return;
-	}
-	else if(sign==BigInteger::NEGATIVE && storage.size()==1 && storage[0]==1)
+	bytes = alignArena(bytes);
+
+	// bump inside the newest chunk, or open a new one large enough
+	if(chunks.empty() || chunks.back().size - used < bytes)
 	{
-		// -1 -> 0
-		operator = (0);
-		return;
+		Chunk chunk;
+		chunk.size = (bytes > chunkBytes) ? bytes : chunkBytes;
+		chunk.begin = static_cast<char*>(::operator new(chunk.size));
+		chunks.push_back(chunk);
+		used = 0;
 	}
 
-	// increment for one
-	storage[0]++;
+	last = chunks.back().begin + used;
+	used += bytes;
+	return last;
+}
 
-	// wrap for all the carries
-	BaseType carry = 0;
-	for(int index = 0; index<storage.size(); index++)
+void ArenaLimbAllocator::deallocate(void* block, std::size_t)
+{
+	// the latest block can be taken back, which is what a growing value
+	// gives up right after its replacement is allocated
+	if(block == last && !chunks.empty())
 	{
-		storage[index] += carry;
-		carry = storage[index]/BigInteger::Base;
-		storage[index] %= BigInteger::Base;
+		used = last - chunks.back().begin;
+		last = 0;
 	}
+}
 
-	if(carry != 0)
-		storage.push_back(carry);
+void ArenaLimbAllocator::reset()
+{
+	if(chunks.empty())
+		return;
+
+	// keep the first chunk, it covers most requests again
+	for(std::size_t index = 1; index < chunks.size(); index++)
+		::operator delete(chunks[index].begin);
+	chunks.resize(1);
+	used = 0;
+	last = 0;
 }
 
-void BigInteger::operator ++ (int)
+std::size_t ArenaLimbAllocator::bytesInUse() const
 {
-	operator ++ ();
+	std::size_t total = used;
+	for(std::size_t index = 0; index + 1 < chunks.size(); index++)
+		total += chunks[index].size;
+	return total;
 }
 
-void BigInteger::operator -- ()
+// one free list per power of two class, linked through the blocks
+struct PoolCache
 {
-	if(isZero())
-	{
-		// 0 -> -1
-		operator = (-1);
-		return;
-	}
-	else if(sign==BigInteger::POSITIVE && storage.size()==1 && storage[0]==1)
+	static const std::size_t Classes = 15;
+
+	void* heads[Classes];
+	std::size_t counts[Classes];
+
+	PoolCache()
 	{
-		// 1 -> 0
-		operator = (0);
-		return;
+		for(std::size_t index = 0; index < Classes; index++)
+		{
+			heads[index] = 0;
+			counts[index] = 0;
+		}
 	}
 
-	BaseType carry = 0;
-
-	// decrement for one
-	if(storage[0] == 0)
+	~PoolCache()
 	{
-		carry = 1;
-		storage[0] = BigInteger::Base-1;
+		release();
 	}
-	else
-		storage[0]--;
 
-	// wrap for all the carries
-	for(int index = 1; index<storage.size(); index++)
+	void release()
 	{
-		if(storage[index]<carry)
-		{
-			storage[index] += BigInteger::Base;
-			storage[index] -= carry;
-			carry = 1;
-		}
-		else
+		for(std::size_t index = 0; index < Classes; index++)
 		{
-			storage[index] -= carry;
-			carry = 0;
+			while(heads[index] != 0)
+			{
+				void* block = heads[index];
+				heads[index] = *static_cast<void**>(block);
+				::operator delete(block);
+			}
+			counts[index] = 0;
 		}
 	}
+};
 
-	removeTrailingZeros();
+// the cache dies with its thread, blocks freed after that (by static
+// objects, say) go back to the heap directly
+static thread_local bool poolClosed = false;
+
+struct PoolCacheHolder
+{
+	PoolCache cache;
+
+	~PoolCacheHolder()
+	{
+		poolClosed = true;
+	}
+};
+
+static PoolCache* poolCache()
+{
+	if(poolClosed)
+		return 0;
+	static thread_local PoolCacheHolder holder;
+	return &holder.cache;
 }
 
-void BigInteger::operator -- (int)
+static std::size_t poolClass(std::size_t bytes)
 {
-	operator -- ();
+	std::size_t index = 0, size = PoolLimbAllocator::MinClassBytes;
+	for(; size < bytes; size <<= 1, index++);
+	return index;
 }
 
-// binary operator: arithmetic
-const BigInteger BigInteger::operator + (const BigInteger& rhs) const
+void* PoolLimbAllocator::allocate(std::size_t bytes)
 {
-	BigInteger result;
-	result.add(*this, rhs);
-	return result;
+	PoolCache* cache = poolCache();
+	if(bytes > MaxClassBytes || cache == 0)
+		return ::operator new((bytes > MaxClassBytes) ? bytes : (MinClassBytes << poolClass(bytes)));
+
+	std::size_t index = poolClass(bytes);
+	void* block = cache->heads[index];
+	if(block == 0)
+		return ::operator new(MinClassBytes << index);
+
+	cache->heads[index] = *static_cast<void**>(block);
+	cache->counts[index]--;
+	return block;
 }
 
-const BigInteger BigInteger::operator - (const BigInteger& rhs) const
+void PoolLimbAllocator::deallocate(void* block, std::size_t bytes)
 {
-	BigInteger result;
-	result.subtract(*this, rhs);
-	return result;
+	PoolCache* cache = poolCache();
+	std::size_t index = poolClass(bytes);
+	if(bytes > MaxClassBytes || cache == 0 || cache->counts[index] >= MaxCachedBlocks)
+	{
+		::operator delete(block);
+		return;
+	}
+
+	*static_cast<void**>(block) = cache->heads[index];
+	cache->heads[index] = block;
+	cache->counts[index]++;
 }
 
-const BigInteger BigInteger::operator * (const BigInteger& rhs) const
+void PoolLimbAllocator::trim()
 {
-	BigInteger result;
-	result.multiply(*this, rhs);
-	return result;
+	PoolCache* cache = poolCache();
+	if(cache != 0)
+		cache->release();
 }
 
-const BigInteger BigInteger::operator / (const BigInteger& rhs) const
+PoolLimbAllocator& PoolLimbAllocator::instance()
 {
-	BigInteger result;
-	result.divide(*this, rhs);
-	return result;
+	static PoolLimbAllocator allocator;
+	return allocator;
 }
 
-const BigInteger BigInteger::operator % (const BigInteger& rhs) const
+#ifdef BIGINTEGER_MAPPED_FILES
+static std::size_t mappedLength(std::size_t bytes)
 {
-	BigInteger result;
-	result.modulus(*this, rhs);
-	return result;
+	std::size_t page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+	return (bytes + page - 1) / page * page;
 }
 
-// binary operator: arithmetic (continue)
-BigInteger& BigInteger::operator += (const BigInteger& rhs)
+MappedLimbAllocator::MappedLimbAllocator(const std::string& directory, std::size_t minimumBytes) : directory(directory), minimumBytes(minimumBytes)
 {
-	//add(*this, rhs);
-	operator = (operator + (rhs));
-	return *this;
 }
 
-BigInteger& BigInteger::operator -= (const BigInteger& rhs)
+void* MappedLimbAllocator::allocate(std::size_t bytes)
 {
-	//subtract(*this, rhs);
-	operator = (operator - (rhs));
-	return *this;
+	if(bytes < minimumBytes)
+		return ::operator new(bytes);
+
+	// the file is unlinked right away, the mapping keeps it alive
+	std::string name = directory + "/biginteger-XXXXXX";
+	std::vector<char> path(name.begin(), name.end());
+	path.push_back('\0');
+	int descriptor = mkstemp(path.data());
+	if(descriptor < 0)
+		throw std::bad_alloc();
+	unlink(path.data());
+
+	std::size_t length = mappedLength(bytes);
+	void* block = MAP_FAILED;
+	if(ftruncate(descriptor, static_cast<off_t>(length)) == 0)
+		block = mmap(0, length, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+	close(descriptor);
+
+	if(block == MAP_FAILED)
+		throw std::bad_alloc();
+	return block;
 }
-BigInteger& BigInteger::operator *= (const BigInteger& rhs)
+
+void MappedLimbAllocator::deallocate(void* block, std::size_t bytes)
 {
-	//multiply(*this, rhs);
-	operator = (operator * (rhs));
-	return *this;
+	if(bytes < minimumBytes)
+		::operator delete(block);
+	else
+		munmap(block, mappedLength(bytes));
 }
+#endif
 
-BigInteger& BigInteger::operator *= (const int& rhs)
+//
+// limb kernels
+//
+// The kernels work on little endian limb arrays. Carries are taken from the
+// double width type, so for binary limbs every "/ Base" and "% Base" below is
+// a shift or a truncation.
+//
+
+// result = lhs + rhs from limb index on with an incoming carry, the scalar
+// kernel and the tail of the vector ones
+static BaseType addLimbsFrom(BaseType* result, const BaseType* lhs, std::size_t lh_size, const BaseType* rhs, std::size_t rh_size, std::size_t index, BaseType carry)
 {
-	int maxIndex = storage.size(), carry = 0;
-	for(int index = 0; index < maxIndex; index++)
+	DoubleBaseType buffer;
+
+	for(; index < rh_size; index++)
 	{
-		storage[index] *= rhs + carry;
-		carry = storage[index]/BigInteger::Base;
-		storage[index] %= BigInteger::Base;
+		buffer = static_cast<DoubleBaseType>(lhs[index]) + rhs[index] + carry;
+		carry = (buffer >= BigInteger::Base) ? 1 : 0;
+		result[index] = static_cast<BaseType>(buffer - (carry ? BigInteger::Base : 0));
 	}
 
-	if(carry != 0)
-		storage.push_back(carry);
+	// past rhs only the carry moves, the rest is a copy
+	for(; index < lh_size && carry != 0; index++)
+	{
+		buffer = static_cast<DoubleBaseType>(lhs[index]) + carry;
+		carry = (buffer >= BigInteger::Base) ? 1 : 0;
+		result[index] = static_cast<BaseType>(buffer - (carry ? BigInteger::Base : 0));
+	}
+	if(result != lhs && index < lh_size)
+		std::memmove(result + index, lhs + index, (lh_size - index)*sizeof(BaseType));
 
-	/*
-	BigInteger rh_obj(rhs);
-	operator = (operator * (rh_obj));
-	*/
-	
-	return *this;
+	return carry;
 }
 
-BigInteger& BigInteger::operator /= (const BigInteger& rhs)
+// result = lhs - rhs from limb index on with an incoming borrow
+static BaseType subtractLimbsFrom(BaseType* result, const BaseType* lhs, std::size_t lh_size, const BaseType* rhs, std::size_t rh_size, std::size_t index, BaseType borrow)
 {
-	//divide(*this, rhs);
-	operator = (operator / (rhs));
-	return *this;
-}
+	DoubleBaseType subtrahend;
 
-BigInteger& BigInteger::operator /= (const int& rhs)
-{
-	if(rhs==2)
+	for(; index < rh_size; index++)
 	{
-		int carry = 0;
-		for(int index = storage.size()-1; index >= 0; index--)
+		// wrap first, since base type is unsigned
+		subtrahend = static_cast<DoubleBaseType>(rhs[index]) + borrow;
+		if(lhs[index] < subtrahend)
 		{
-			if(carry == 1)
-				storage[index] += BigInteger::Base;
-
-			carry = storage[index]%2;
-			storage[index] /= 2;
+			result[index] = static_cast<BaseType>(lhs[index] + BigInteger::Base - subtrahend);
+			borrow = 1;
 		}
+		else
+		{
+			result[index] = static_cast<BaseType>(lhs[index] - subtrahend);
+			borrow = 0;
+		}
+	}
 
-		removeTrailingZeros();
+	for(; index < lh_size && borrow != 0; index++)
+	{
+		borrow = (lhs[index] == 0) ? 1 : 0;
+		result[index] = static_cast<BaseType>(borrow ? BigInteger::Base - 1 : lhs[index] - 1);
 	}
-	else
+	if(result != lhs && index < lh_size)
+		std::memmove(result + index, lhs + index, (lh_size - index)*sizeof(BaseType));
+
+	return borrow;
+}
+
+// compare the equally long lhs and rhs from limb index down
+static int compareLimbsFrom(const BaseType* lhs, const BaseType* rhs, std::size_t index)
+{
+	while(index-- > 0)
 	{
-		BigInteger rh_obj(rhs);
-		operator = (operator / (rh_obj));
+		if(lhs[index] != rhs[index])
+			return (lhs[index] > rhs[index]) ? 1 : -1;
 	}
 
-	return *this;
+	return 0;
 }
 
-BigInteger& BigInteger::operator %= (const BigInteger& rhs)
+#if !defined(BIGINTEGER_LIMB_BITS) || BIGINTEGER_LIMB_BITS == 32
+// low[i] (+ high[i]) += lhs[i] * rhs from index on, the row step of the
+// basecase multiplication. Decimal products fit low as they are, binary ones
+// are split so that low takes the bottom 32 bits and high the top 32 bits
+// of each product, high[i] then belongs to the next column up.
+static void multiplyRowFrom(DoubleBaseType* low, DoubleBaseType* high, const BaseType* lhs, std::size_t size, BaseType rhs, std::size_t index)
 {
-	//modulus(*this, rhs);
-	operator = (operator % (rhs));
-	return *this;
+	DoubleBaseType product;
+
+	for(; index < size; index++)
+	{
+		product = static_cast<DoubleBaseType>(lhs[index]) * rhs;
+#if !defined(BIGINTEGER_LIMB_BITS)
+		low[index] += product;
+		(void) high;
+#else
+		low[index] += product & 0xffffffffULL;
+		high[index] += product >> 32;
+#endif
+	}
 }
+#endif
 
-// binary operator: comparison
-bool BigInteger::operator > (const BigInteger& rhs) const
+//
+// vector kernels
+//
+// Each block of lanes is added or subtracted lane by lane first. A lane then
+// generates a carry (or borrow) when it overflowed, and propagates one when
+// it sits at Base-1 (or 0). With those two bit masks the carry into every
+// lane comes out of one integer addition, as in a carry lookahead adder:
+// x = propagate + (generate << 1 | carry), the lane carries are x ^ propagate
+// and the block carry is the bit above the lanes.
+//
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && !defined(BIGINTEGER_NO_SIMD)
+#define BIGINTEGER_X86_SIMD
+#endif
+
+#ifdef BIGINTEGER_X86_SIMD
+#include <immintrin.h>
+
+// limbs per 256 and 512 bit register
+static const std::size_t AVX2Lanes = 32 / sizeof(BaseType);
+static const std::size_t AVX512Lanes = 64 / sizeof(BaseType);
+
+#if defined(BIGINTEGER_LIMB_BITS) && BIGINTEGER_LIMB_BITS == 64
+#define AVX2_LANE(name) name##_epi64
+#define AVX2_SET1(value) _mm256_set1_epi64x(static_cast<long long>(value))
+#define AVX512_LANE(name) name##_epi64
+#define AVX512_LANE_UNSIGNED(name) name##_epu64_mask
+#define AVX512_SET1(value) _mm512_set1_epi64(static_cast<long long>(value))
+#else
+#define AVX2_LANE(name) name##_epi32
+#define AVX2_SET1(value) _mm256_set1_epi32(static_cast<int>(value))
+#define AVX512_LANE(name) name##_epi32
+#define AVX512_LANE_UNSIGNED(name) name##_epu32_mask
+#define AVX512_SET1(value) _mm512_set1_epi32(static_cast<int>(value))
+#endif
+
+// one bit per lane from a lane wide comparison result
+__attribute__((target("avx2")))
+static inline unsigned avx2Mask(__m256i lanes)
 {
-	return compare(*this, rhs) == BigInteger::GREATER;
+#if defined(BIGINTEGER_LIMB_BITS) && BIGINTEGER_LIMB_BITS == 64
+	return static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(lanes)));
+#else
+	return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(lanes)));
+#endif
 }
 
-bool BigInteger::operator == (const BigInteger& rhs) const
+// the lane carries as 0 or 1 in every lane
+__attribute__((target("avx2")))
+static inline __m256i avx2Expand(unsigned carries)
 {
-	return compare(*this, rhs) == BigInteger::EQUAL;
+#if defined(BIGINTEGER_LIMB_BITS) && BIGINTEGER_LIMB_BITS == 64
+	__m256i shifts = _mm256_setr_epi64x(0, 1, 2, 3);
+	return _mm256_and_si256(_mm256_srlv_epi64(AVX2_SET1(carries), shifts), AVX2_SET1(1));
+#else
+	__m256i shifts = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	return _mm256_and_si256(_mm256_srlv_epi32(AVX2_SET1(carries), shifts), AVX2_SET1(1));
+#endif
 }
 
-bool BigInteger::operator < (const BigInteger& rhs) const
+// lanes carries out of generate/propagate masks, updates the block carry
+static inline unsigned lookahead(unsigned generate, unsigned propagate, unsigned& carry, std::size_t lanes)
 {
-	return compare(*this, rhs) == BigInteger::LESS;
+	unsigned sum = propagate + ((generate << 1) | carry);
+	carry = (sum >> lanes) & 1;
+	return (sum ^ propagate) & ((1u << lanes) - 1);
 }
 
-bool BigInteger::operator >= (const BigInteger& rhs) const
+__attribute__((target("avx2")))
+static inline __m256i avx2AddBlock(__m256i lhs, __m256i rhs, unsigned& carry)
 {
-	return operator > (rhs) || operator == (rhs);
+	__m256i sum = AVX2_LANE(_mm256_add)(lhs, rhs);
+#if !defined(BIGINTEGER_LIMB_BITS)
+	// decimal lanes never wrap, they overflow past Base-1
+	__m256i top = AVX2_SET1(BigInteger::Base - 1);
+	unsigned generate = avx2Mask(AVX2_LANE(_mm256_cmpgt)(sum, top));
+	unsigned propagate = avx2Mask(AVX2_LANE(_mm256_cmpeq)(sum, top));
+	sum = AVX2_LANE(_mm256_add)(sum, avx2Expand(lookahead(generate, propagate, carry, AVX2Lanes)));
+	__m256i over = AVX2_LANE(_mm256_cmpgt)(sum, top);
+	return AVX2_LANE(_mm256_sub)(sum, _mm256_and_si256(over, AVX2_SET1(BigInteger::Base)));
+#else
+	// unsigned sum < lhs through the signed compare with flipped top bits
+	__m256i flip = AVX2_SET1(static_cast<BaseType>(1) << (sizeof(BaseType)*8 - 1));
+	unsigned generate = avx2Mask(AVX2_LANE(_mm256_cmpgt)(_mm256_xor_si256(lhs, flip), _mm256_xor_si256(sum, flip)));
+	unsigned propagate = avx2Mask(AVX2_LANE(_mm256_cmpeq)(sum, AVX2_SET1(~static_cast<BaseType>(0))));
+	return AVX2_LANE(_mm256_add)(sum, avx2Expand(lookahead(generate, propagate, carry, AVX2Lanes)));
+#endif
 }
 
-bool BigInteger::operator != (const BigInteger& rhs) const
+__attribute__((target("avx2")))
+static inline __m256i avx2SubtractBlock(__m256i lhs, __m256i rhs, unsigned& borrow)
 {
-	return !operator == (rhs);
+	__m256i difference = AVX2_LANE(_mm256_sub)(lhs, rhs);
+	__m256i zero = _mm256_setzero_si256();
+#if !defined(BIGINTEGER_LIMB_BITS)
+	__m256i under = AVX2_LANE(_mm256_cmpgt)(zero, difference);
+	unsigned generate = avx2Mask(under);
+	difference = AVX2_LANE(_mm256_add)(difference, _mm256_and_si256(under, AVX2_SET1(BigInteger::Base)));
+	unsigned propagate = avx2Mask(AVX2_LANE(_mm256_cmpeq)(difference, zero));
+	difference = AVX2_LANE(_mm256_sub)(difference, avx2Expand(lookahead(generate, propagate, borrow, AVX2Lanes)));
+	under = AVX2_LANE(_mm256_cmpgt)(zero, difference);
+	return AVX2_LANE(_mm256_add)(difference, _mm256_and_si256(under, AVX2_SET1(BigInteger::Base)));
+#else
+	__m256i flip = AVX2_SET1(static_cast<BaseType>(1) << (sizeof(BaseType)*8 - 1));
+	unsigned generate = avx2Mask(AVX2_LANE(_mm256_cmpgt)(_mm256_xor_si256(rhs, flip), _mm256_xor_si256(lhs, flip)));
+	unsigned propagate = avx2Mask(AVX2_LANE(_mm256_cmpeq)(difference, zero));
+	return AVX2_LANE(_mm256_sub)(difference, avx2Expand(lookahead(generate, propagate, borrow, AVX2Lanes)));
+#endif
 }
 
-bool BigInteger::operator <= (const BigInteger& rhs) const
+__attribute__((target("avx2")))
+static BaseType addLimbsAVX2(BaseType* result, const BaseType* lhs, std::size_t lh_size, const BaseType* rhs, std::size_t rh_size)
 {
-	return operator < (rhs) || operator == (rhs);
+	unsigned carry = 0;
+	std::size_t index = 0;
+	for(; index + AVX2Lanes <= rh_size; index += AVX2Lanes)
+	{
+		__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs + index));
+		__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs + index));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(result + index), avx2AddBlock(a, b, carry));
+	}
+
+	return addLimbsFrom(result, lhs, lh_size, rhs, rh_size, index, carry);
 }
 
-// binary operator: stream and memroy operation
-BigInteger& BigInteger::operator = (const BigInteger& rhs)
+__attribute__((target("avx2")))
+static BaseType subtractLimbsAVX2(BaseType* result, const BaseType* lhs, std::size_t lh_size, const BaseType* rhs, std::size_t rh_size)
 {
-	// copy sign
-	sign = rhs.sign;
+	unsigned borrow = 0;
+	std::size_t index = 0;
+	for(; index + AVX2Lanes <= rh_size; index += AVX2Lanes)
+	{
+		__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs + index));
+		__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs + index));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(result + index), avx2SubtractBlock(a, b, borrow));
+	}
 
-	// wipe the storage
-	storage.clear();
+	return subtractLimbsFrom(result, lhs, lh_size, rhs, rh_size, index, borrow);
+}
 
-	// reserve the memory space for faster copy speed
-	storage.reserve(rhs.storage.size());
+__attribute__((target("avx2")))
+static int compareLimbsAVX2(const BaseType* lhs, const BaseType* rhs, std::size_t size)
+{
+	// skip equal blocks from the top, the first unequal one is settled by
+	// the scalar loop
+	std::size_t index = size;
+	for(; index >= AVX2Lanes; index -= AVX2Lanes)
+	{
+		__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs + index - AVX2Lanes));
+		__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs + index - AVX2Lanes));
+		if(avx2Mask(AVX2_LANE(_mm256_cmpeq)(a, b)) != (1u << AVX2Lanes) - 1)
+			return compareLimbsFrom(lhs, rhs, index);
+	}
 
-	// start performing deep copy
-	std::vector<BigInteger::BaseType>::const_iterator iterator;
-	for(iterator = rhs.storage.begin(); iterator != rhs.storage.end(); ++iterator)
-		storage.push_back(*iterator);
+	return compareLimbsFrom(lhs, rhs, index);
+}
 
-	return *this;
+__attribute__((target("avx512f")))
+static inline __m512i avx512AddBlock(__m512i lhs, __m512i rhs, unsigned& carry)
+{
+	__m512i sum = AVX512_LANE(_mm512_add)(lhs, rhs);
+#if !defined(BIGINTEGER_LIMB_BITS)
+	__m512i top = AVX512_SET1(BigInteger::Base - 1);
+	unsigned generate = AVX512_LANE_UNSIGNED(_mm512_cmpgt)(sum, top);
+	unsigned propagate = AVX512_LANE_UNSIGNED(_mm512_cmpeq)(sum, top);
+	unsigned carries = lookahead(generate, propagate, carry, AVX512Lanes);
+	sum = AVX512_LANE(_mm512_mask_add)(sum, carries, sum, AVX512_SET1(1));
+	return AVX512_LANE(_mm512_mask_sub)(sum, AVX512_LANE_UNSIGNED(_mm512_cmpgt)(sum, top), sum, AVX512_SET1(BigInteger::Base));
+#else
+	unsigned generate = AVX512_LANE_UNSIGNED(_mm512_cmplt)(sum, lhs);
+	unsigned propagate = AVX512_LANE_UNSIGNED(_mm512_cmpeq)(sum, AVX512_SET1(~static_cast<BaseType>(0)));
+	unsigned carries = lookahead(generate, propagate, carry, AVX512Lanes);
+	return AVX512_LANE(_mm512_mask_add)(sum, carries, sum, AVX512_SET1(1));
+#endif
 }
 
-BigInteger& BigInteger::operator = (const int& rhs)
+__attribute__((target("avx512f")))
+static inline __m512i avx512SubtractBlock(__m512i lhs, __m512i rhs, unsigned& borrow)
+{
+	__m512i difference = AVX512_LANE(_mm512_sub)(lhs, rhs);
+	unsigned generate = AVX512_LANE_UNSIGNED(_mm512_cmplt)(lhs, rhs);
+#if !defined(BIGINTEGER_LIMB_BITS)
+	difference = AVX512_LANE(_mm512_mask_add)(difference, generate, difference, AVX512_SET1(BigInteger::Base));
+#endif
+	unsigned propagate = AVX512_LANE_UNSIGNED(_mm512_cmpeq)(difference, _mm512_setzero_si512());
+	unsigned borrows = lookahead(generate, propagate, borrow, AVX512Lanes);
+#if !defined(BIGINTEGER_LIMB_BITS)
+	// a lane at zero that takes a borrow wraps to Base-1
+	difference = AVX512_LANE(_mm512_mask_add)(difference, borrows & propagate, difference, AVX512_SET1(BigInteger::Base));
+#endif
+	return AVX512_LANE(_mm512_mask_sub)(difference, borrows, difference, AVX512_SET1(1));
+}
+
+__attribute__((target("avx512f")))
+static BaseType addLimbsAVX512(BaseType* result, const BaseType* lhs, std::size_t lh_size, const BaseType* rhs, std::size_t rh_size)
 {
-	int temp = rhs;
+	unsigned carry = 0;
+	std::size_t index = 0;
+	for(; index + AVX512Lanes <= rh_size; index += AVX512Lanes)
+	{
+		__m512i a = _mm512_loadu_si512(lhs + index);
+		__m512i b = _mm512_loadu_si512(rhs + index);
+		_mm512_storeu_si512(result + index, avx512AddBlock(a, b, carry));
+	}
 
-	// empty the storage
-	storage.clear();
-	storage.reserve(3);
+	return addLimbsFrom(result, lhs, lh_size, rhs, rh_size, index, carry);
+}
 
-	// register the sign of default value
-	if(temp == 0)
-		sign = BigInteger::ZERO;
-	else if(temp > 0)
-		sign = BigInteger::POSITIVE;
-	else
+__attribute__((target("avx512f")))
+static BaseType subtractLimbsAVX512(BaseType* result, const BaseType* lhs, std::size_t lh_size, const BaseType* rhs, std::size_t rh_size)
+{
+	unsigned borrow = 0;
+	std::size_t index = 0;
+	for(; index + AVX512Lanes <= rh_size; index += AVX512Lanes)
 	{
-		sign = BigInteger::NEGATIVE;
-		temp *= -1;
+		__m512i a = _mm512_loadu_si512(lhs + index);
+		__m512i b = _mm512_loadu_si512(rhs + index);
+		_mm512_storeu_si512(result + index, avx512SubtractBlock(a, b, borrow));
 	}
 
-	while(temp > 0)
+	return subtractLimbsFrom(result, lhs, lh_size, rhs, rh_size, index, borrow);
+}
+
+__attribute__((target("avx512f")))
+static int compareLimbsAVX512(const BaseType* lhs, const BaseType* rhs, std::size_t size)
+{
+	std::size_t index = size;
+	for(; index >= AVX512Lanes; index -= AVX512Lanes)
 	{
-		storage.push_back(temp%BigInteger::Base);
-		temp /= BigInteger::Base;
+		__m512i a = _mm512_loadu_si512(lhs + index - AVX512Lanes);
+		__m512i b = _mm512_loadu_si512(rhs + index - AVX512Lanes);
+		if(AVX512_LANE_UNSIGNED(_mm512_cmpneq)(a, b) != 0)
+			return compareLimbsFrom(lhs, rhs, index);
 	}
 
-	return *this;
+	return compareLimbsFrom(lhs, rhs, index);
 }
 
-std::ostream& operator << (std::ostream& stream, const BigInteger& rhs)
+#if !defined(BIGINTEGER_LIMB_BITS) || BIGINTEGER_LIMB_BITS == 32
+__attribute__((target("avx2")))
+static void multiplyRowAVX2(DoubleBaseType* low, DoubleBaseType* high, const BaseType* lhs, std::size_t size, BaseType rhs)
 {
-	switch(rhs.sign)
+	const __m256i multiplier = _mm256_set1_epi64x(static_cast<long long>(rhs));
+	std::size_t index = 0;
+	for(; index + 4 <= size; index += 4)
 	{
-		case BigInteger::NEGATIVE:
-			stream << '-';
-			break;
-		case BigInteger::ZERO:
-			stream << '0';
-			return stream;
-		case BigInteger::POSITIVE:
-			#ifdef FORCE_SHOW_POSITIVE
-			stream << '+';
-			#endif
-			break;
-		default:
-			throw "BigInteger::operator<<(std::ostream&, const BigInteger&) -> Sign undefine";
+		__m256i product = _mm256_mul_epu32(_mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs + index))), multiplier);
+#if !defined(BIGINTEGER_LIMB_BITS)
+		__m256i sum = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(low + index));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(low + index), _mm256_add_epi64(sum, product));
+#else
+		__m256i sum = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(low + index));
+		__m256i lowHalf = _mm256_and_si256(product, _mm256_set1_epi64x(0xffffffffLL));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(low + index), _mm256_add_epi64(sum, lowHalf));
+		sum = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(high + index));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(high + index), _mm256_add_epi64(sum, _mm256_srli_epi64(product, 32)));
+#endif
 	}
 
-	// print the first group without padding
-	std::cout << rhs.storage.back();
+	multiplyRowFrom(low, high, lhs, size, rhs, index);
+}
 
-	// reverse iterate the groups and print them out
-	std::vector<BigInteger::BaseType>::const_reverse_iterator iterator = rhs.storage.rbegin();
-	for(iterator++; iterator != rhs.storage.rend(); ++iterator)
-		stream << std::setfill('0') << std::setw(BigInteger::BaseMagnitude10) << *iterator;
+__attribute__((target("avx512f")))
+static void multiplyRowAVX512(DoubleBaseType* low, DoubleBaseType* high, const BaseType* lhs, std::size_t size, BaseType rhs)
+{
+	// the zero masked forms, the plain ones trip a bogus uninitialized
+	// warning in some gcc versions
+	const __m512i multiplier = _mm512_set1_epi64(static_cast<long long>(rhs));
+	const __mmask8 all = 0xff;
+	std::size_t index = 0;
+	for(; index + 8 <= size; index += 8)
+	{
+		__m512i limbs = _mm512_maskz_cvtepu32_epi64(all, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs + index)));
+		__m512i product = _mm512_maskz_mul_epu32(all, limbs, multiplier);
+#if !defined(BIGINTEGER_LIMB_BITS)
+		_mm512_storeu_si512(low + index, _mm512_add_epi64(_mm512_loadu_si512(low + index), product));
+#else
+		__m512i lowHalf = _mm512_maskz_and_epi64(all, product, _mm512_set1_epi64(0xffffffffLL));
+		_mm512_storeu_si512(low + index, _mm512_add_epi64(_mm512_loadu_si512(low + index), lowHalf));
+		_mm512_storeu_si512(high + index, _mm512_add_epi64(_mm512_loadu_si512(high + index), _mm512_maskz_srli_epi64(all, product, 32)));
+#endif
+	}
 
-	return stream;
+	multiplyRowFrom(low, high, lhs, size, rhs, index);
 }
+#endif
+#endif
 
-bool BigInteger::iseven()
+static BaseType addLimbsScalar(BaseType* result, const BaseType* lhs, std::size_t lh_size, const BaseType* rhs, std::size_t rh_size)
 {
-	if(storage.front()%2==0)
-		return true;
-	else
-		return false;
+	return addLimbsFrom(result, lhs, lh_size, rhs, rh_size, 0, 0);
 }
 
-bool BigInteger::iszero() const
+static BaseType subtractLimbsScalar(BaseType* result, const BaseType* lhs, std::size_t lh_size, const BaseType* rhs, std::size_t rh_size)
 {
-	return isZero();
+	return subtractLimbsFrom(result, lhs, lh_size, rhs, rh_size, 0, 0);
 }
 
-//
-// support functions
-//
-void BigInteger::add(const BigInteger& lhs, const BigInteger& rhs)
+static int compareLimbsScalar(const BaseType* lhs, const BaseType* rhs, std::size_t size)
 {
-	#ifdef DEBUG_ADD
-	std::cout << "=====" << std::endl;
-	std::cout << "add() called" << std::endl;
-	#endif
+	return compareLimbsFrom(lhs, rhs, size);
+}
 
-	if(lhs.sign == BigInteger::ZERO)
+#if !defined(BIGINTEGER_LIMB_BITS) || BIGINTEGER_LIMB_BITS == 32
+static void multiplyRowScalar(DoubleBaseType* low, DoubleBaseType* high, const BaseType* lhs, std::size_t size, BaseType rhs)
+{
+	multiplyRowFrom(low, high, lhs, size, rhs, 0);
+}
+#endif
+
+// the kernels picked for this cpu, on first use
+struct LimbKernels
+{
+	BaseType (*add)(BaseType*, const BaseType*, std::size_t, const BaseType*, std::size_t);
+	BaseType (*subtract)(BaseType*, const BaseType*, std::size_t, const BaseType*, std::size_t);
+	int (*compare)(const BaseType*, const BaseType*, std::size_t);
+#if !defined(BIGINTEGER_LIMB_BITS) || BIGINTEGER_LIMB_BITS == 32
+	void (*multiplyRow)(DoubleBaseType*, DoubleBaseType*, const BaseType*, std::size_t, BaseType);
+#endif
+};
+
+static LimbKernels selectLimbKernels()
+{
+	LimbKernels kernels;
+	kernels.add = addLimbsScalar;
+	kernels.subtract = subtractLimbsScalar;
+	kernels.compare = compareLimbsScalar;
+#if !defined(BIGINTEGER_LIMB_BITS) || BIGINTEGER_LIMB_BITS == 32
+	kernels.multiplyRow = multiplyRowScalar;
+#endif
+
+#ifdef BIGINTEGER_X86_SIMD
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx512f"))
 	{
-		operator = (rhs);
-		return;
+		kernels.add = addLimbsAVX512;
+		kernels.subtract = subtractLimbsAVX512;
+		kernels.compare = compareLimbsAVX512;
+#if !defined(BIGINTEGER_LIMB_BITS) || BIGINTEGER_LIMB_BITS == 32
+		kernels.multiplyRow = multiplyRowAVX512;
+#endif
 	}
-	else if(rhs.sign == ZERO)
+	else if(__builtin_cpu_supports("avx2"))
 	{
-		operator = (lhs);
-		return;
+		kernels.add = addLimbsAVX2;
+		kernels.subtract = subtractLimbsAVX2;
+		kernels.compare = compareLimbsAVX2;
+#if !defined(BIGINTEGER_LIMB_BITS) || BIGINTEGER_LIMB_BITS == 32
+		kernels.multiplyRow = multiplyRowAVX2;
+#endif
 	}
+#endif
 
-	// rearrange according to the magnitude
-	const BigInteger *lh_obj, *rh_obj;
-	if(compareMagnitude(lhs, rhs) == LESS)
-	{
-		lh_obj = &rhs;
-		rh_obj = &lhs;
-	}
-	else
-	{
-		lh_obj = &lhs;
-		rh_obj = &rhs;
-	}
+	return kernels;
+}
 
-	#ifdef DEBUG_ADD
-	std::cout << "lh_obj: " << *lh_obj << "; rh_obj: " << *rh_obj << std::endl;
-	#endif
+static const LimbKernels& limbKernels()
+{
+	static const LimbKernels kernels = selectLimbKernels();
+	return kernels;
+}
 
-	if(lhs.sign == rhs.sign)
-	{
-		// duplicate the longer one, and ignore if it's itself
-		if(lh_obj != this)
-			operator = (*lh_obj);
+// operands shorter than this stay on the scalar loop, the dispatch would
+// cost more than the vectors save
+static const std::size_t VectorMinLimbs = 16;
 
-		BaseType carry = 0, buffer;
-		// iterate through rh_obj, add with lh_obj, and store into *this
-		for(std::vector<int>::size_type index = 0; index<rh_obj->storage.size(); index++)
-		{
-			// add the carry
-			buffer = lh_obj->storage[index] + rh_obj->storage[index] + carry;
+// result = lhs + rhs, requires lh_size >= rh_size, result may alias either
+// operand, returns the carry out of the top limb
+static BaseType addLimbs(BaseType* result, const BaseType* lhs, std::size_t lh_size, const BaseType* rhs, std::size_t rh_size)
+{
+	if(rh_size < VectorMinLimbs)
+		return addLimbsFrom(result, lhs, lh_size, rhs, rh_size, 0, 0);
+	return limbKernels().add(result, lhs, lh_size, rhs, rh_size);
+}
 
-			// wrap the digit
-			carry = buffer/BigInteger::Base;
-			buffer %= BigInteger::Base;
+// result = lhs - rhs, requires lh_size >= rh_size, result may alias either
+// operand, returns the borrow out of the top limb
+static BaseType subtractLimbs(BaseType* result, const BaseType* lhs, std::size_t lh_size, const BaseType* rhs, std::size_t rh_size)
+{
+	if(rh_size < VectorMinLimbs)
+		return subtractLimbsFrom(result, lhs, lh_size, rhs, rh_size, 0, 0);
+	return limbKernels().subtract(result, lhs, lh_size, rhs, rh_size);
+}
 
-			// store back
-			storage[index] = buffer;
-		}
+// compare two normalized magnitudes, returns -1, 0 or 1
+static int compareLimbs(const BaseType* lhs, std::size_t lh_size, const BaseType* rhs, std::size_t rh_size)
+{
+	if(lh_size != rh_size)
+		return (lh_size > rh_size) ? 1 : -1;
+	if(lh_size < VectorMinLimbs)
+		return compareLimbsFrom(lhs, rhs, lh_size);
+	return limbKernels().compare(lhs, rhs, lh_size);
+}
 
-		if(carry > 0)
-			storage.push_back(carry);
+// shorter operands are multiplied one product at a time, below this the
+// deferred carries don't pay for their setup
+static const std::size_t MultiplyDeferredLimbs = 8;
+
+// lhs limbs per block of the basecase multiplication, and the accumulator
+// words that still fit on the stack
+static const std::size_t MultiplyBlockLimbs = 128;
+static const std::size_t MultiplyStackWords = 1024;
+
+#if !defined(BIGINTEGER_LIMB_BITS) || BIGINTEGER_LIMB_BITS == 32
+// result = lhs * rhs, as multiplyLimbs()
+//
+// The products are summed column by column in wide accumulators, one row of
+// rhs at a time, and the carries are only resolved once per block of lhs.
+// A column takes at most rh_size products, which can't overflow the
+// accumulators for any operand that fits in memory.
+static void multiplyLimbsDeferred(BaseType* result, const BaseType* lhs, std::size_t lh_size, const BaseType* rhs, std::size_t rh_size)
+{
+	const LimbKernels& kernels = limbKernels();
+	std::size_t block = (lh_size < MultiplyBlockLimbs) ? lh_size : MultiplyBlockLimbs;
+	std::size_t words = 2*(block+rh_size+1);
+	DoubleBaseType stackWords[MultiplyStackWords];
+	std::vector<DoubleBaseType> heapWords;
+	DoubleBaseType* low = stackWords;
+	if(words > MultiplyStackWords)
+	{
+		heapWords.resize(words);
+		low = heapWords.data();
 	}
-	else
+	DoubleBaseType* high = low+block+rh_size+1;
+	DoubleBaseType carry, column;
+	std::size_t piece, columns;
+
+	for(std::size_t offset = 0; offset < lh_size; offset += block)
 	{
-		if(lh_obj->sign == POSITIVE)
+		piece = (lh_size-offset < block) ? lh_size-offset : block;
+		columns = piece+rh_size;
+		for(std::size_t index = 0; index <= columns; index++)
+			low[index] = high[index] = 0;
+
+		for(std::size_t row = 0; row < rh_size; row++)
+			kernels.multiplyRow(low+row, high+row+1, lhs+offset, piece, rhs[row]);
+
+		// the previous block left its top rh_size limbs where this one starts
+		if(offset > 0)
 		{
-			// +LARGE -SMALL
-			subtract(*lh_obj, -(*rh_obj));
+			for(std::size_t index = 0; index < rh_size; index++)
+				low[index] += result[offset+index];
 		}
-		else
-		{
-			// -LARGE +SMALL
 
-			// subtract as +LARGE +SMALL
-			subtract(-(*lh_obj), *rh_obj);
-			//*this = -(*this);
-			operator - ();
+		carry = 0;
+		for(std::size_t index = 0; index < columns; index++)
+		{
+			column = low[index] + high[index] + carry;
+			result[offset+index] = static_cast<BaseType>(column % BigInteger::Base);
+			carry = column / BigInteger::Base;
 		}
 	}
+}
+#else
+// result = lhs * rhs, as multiplyLimbs()
+//
+// There are no vector 64 by 64 bit multiplications, so the product is
+// scanned column by column instead. The 128 bit products of a column are
+// summed in three words and the carry goes up once per column.
+static void multiplyLimbsDeferred(BaseType* result, const BaseType* lhs, std::size_t lh_size, const BaseType* rhs, std::size_t rh_size)
+{
+	DoubleBaseType sum = 0, product;
+	BaseType overflow = 0;
+	std::size_t first, last;
 
-	#ifdef DEBUG_ADD
-	std::cout << "add(): result is " << *this << std::endl;
-	std::cout << "=====" << std::endl;
-	#endif
+	for(std::size_t column = 0; column+1 < lh_size+rh_size; column++)
+	{
+		first = (column < rh_size) ? 0 : column-rh_size+1;
+		last = (column < lh_size) ? column : lh_size-1;
+		for(std::size_t index = first; index <= last; index++)
+		{
+			product = static_cast<DoubleBaseType>(lhs[index]) * rhs[column-index];
+			sum += product;
+			overflow += (sum < product) ? 1 : 0;
+		}
+
+		result[column] = static_cast<BaseType>(sum);
+		sum = (sum >> 64) | (static_cast<DoubleBaseType>(overflow) << 64);
+		overflow = 0;
+	}
+	result[lh_size+rh_size-1] = static_cast<BaseType>(sum);
 }
+#endif
 
-void BigInteger::subtract(const BigInteger& lhs, const BigInteger& rhs)
+// result = lhs * rhs, result holds lh_size+rh_size limbs and must not alias
+// the operands
+static void multiplyLimbs(BaseType* result, const BaseType* lhs, std::size_t lh_size, const BaseType* rhs, std::size_t rh_size)
 {
-	#ifdef DEBUG_SUBTRACT
-	std::cout << "=====" << std::endl;
-	std::cout << "subtract() called" << std::endl;
-	#endif
+	if(lh_size >= MultiplyDeferredLimbs && rh_size >= MultiplyDeferredLimbs)
+	{
+		multiplyLimbsDeferred(result, lhs, lh_size, rhs, rh_size);
+		return;
+	}
 
-	if(lhs.sign == ZERO)
+	DoubleBaseType buffer;
+	BaseType carry;
+
+	for(std::size_t index = 0; index < lh_size+rh_size; index++)
+		result[index] = 0;
+
+	for(std::size_t lowerIndex = 0; lowerIndex < rh_size; lowerIndex++)
 	{
-		#ifdef DEBUG_SUBTRACT
-		std::cout << "...lhs is ZERO" << std::endl;
-		#endif
+		carry = 0;
+		for(std::size_t upperIndex = 0; upperIndex < lh_size; upperIndex++)
+		{
+			buffer = static_cast<DoubleBaseType>(lhs[upperIndex]) * rhs[lowerIndex] + result[lowerIndex+upperIndex] + carry;
+			carry = static_cast<BaseType>(buffer / BigInteger::Base);
+			result[lowerIndex+upperIndex] = static_cast<BaseType>(buffer % BigInteger::Base);
+		}
+		result[lowerIndex+lh_size] = carry;
+	}
+}
 
-		operator = (rhs);
-		//*this = -(*this);
-		operator - ();
+#if !defined(BIGINTEGER_LIMB_BITS) || BIGINTEGER_LIMB_BITS == 32
+// result = operand^2, result holds 2*size limbs and must not alias the
+// operand
+//
+// Only the products above the diagonal go through the row kernel. Their
+// columns are doubled while the carries are resolved, and the squares of
+// the limbs are added on the diagonal on the way.
+static void squareLimbs(BaseType* result, const BaseType* operand, std::size_t size)
+{
+	if(size < MultiplyDeferredLimbs || 2*size > MultiplyStackWords/2)
+	{
+		multiplyLimbs(result, operand, size, operand, size);
 		return;
 	}
-	else if(rhs.sign == ZERO)
-	{
-		#ifdef DEBUG_SUBTRACT
-		std::cout << "...rhs is ZERO" << std::endl;
-		#endif
 
-		operator = (lhs);
+	const LimbKernels& kernels = limbKernels();
+	DoubleBaseType low[MultiplyStackWords/2], high[MultiplyStackWords/2];
+	DoubleBaseType carry = 0, column, product;
+
+	for(std::size_t index = 0; index < 2*size; index++)
+		low[index] = high[index] = 0;
+
+	for(std::size_t row = 0; row+1 < size; row++)
+		kernels.multiplyRow(low+2*row+1, high+2*row+2, operand+row+1, size-row-1, operand[row]);
+
+	for(std::size_t index = 0; index < 2*size; index++)
+	{
+		column = 2*(low[index] + high[index]) + carry;
+		product = static_cast<DoubleBaseType>(operand[index/2]) * operand[index/2];
+#if !defined(BIGINTEGER_LIMB_BITS)
+		if(index % 2 == 0)
+			column += product;
+#else
+		column += (index % 2 == 0) ? (product & 0xffffffffULL) : (product >> 32);
+#endif
+		result[index] = static_cast<BaseType>(column % BigInteger::Base);
+		carry = column / BigInteger::Base;
+	}
+}
+#else
+// result = operand^2, result holds 2*size limbs and must not alias the
+// operand
+//
+// Column by column as in multiplyLimbsDeferred(), the products above the
+// diagonal are summed once and doubled before the square on the diagonal
+// and the carry from the column below go in.
+static void squareLimbs(BaseType* result, const BaseType* operand, std::size_t size)
+{
+	if(size < MultiplyDeferredLimbs)
+	{
+		multiplyLimbs(result, operand, size, operand, size);
 		return;
 	}
 
-	// rearrange according to the magnitude
-	const BigInteger *lh_obj, *rh_obj;
-	if(compareMagnitude(lhs, rhs) == LESS)
+	DoubleBaseType sum, product, carry = 0;
+	BaseType overflow;
+	std::size_t first;
+
+	for(std::size_t column = 0; column+1 < 2*size; column++)
 	{
-		lh_obj = &rhs;
-		rh_obj = &lhs;
+		sum = 0;
+		overflow = 0;
+		first = (column < size) ? 0 : column-size+1;
+		for(std::size_t index = first; 2*index < column; index++)
+		{
+			product = static_cast<DoubleBaseType>(operand[index]) * operand[column-index];
+			sum += product;
+			overflow += (sum < product) ? 1 : 0;
+		}
+
+		overflow = static_cast<BaseType>((overflow << 1) | static_cast<BaseType>(sum >> 127));
+		sum <<= 1;
+		if(column % 2 == 0)
+		{
+			product = static_cast<DoubleBaseType>(operand[column/2]) * operand[column/2];
+			sum += product;
+			overflow += (sum < product) ? 1 : 0;
+		}
+		sum += carry;
+		overflow += (sum < carry) ? 1 : 0;
+
+		result[column] = static_cast<BaseType>(sum);
+		carry = (sum >> 64) | (static_cast<DoubleBaseType>(overflow) << 64);
 	}
-	else
+	result[2*size-1] = static_cast<BaseType>(carry);
+}
+#endif
+
+// result = lhs * rhs + carry for a single limb multiplier, result may alias
+// lhs, returns the carry out of the top limb
+static BaseType multiplySmall(BaseType* result, const BaseType* lhs, std::size_t size, BaseType rhs, BaseType carry = 0)
+{
+	DoubleBaseType buffer;
+
+	for(std::size_t index = 0; index < size; index++)
 	{
-		lh_obj = &lhs;
-		rh_obj = &rhs;
+		buffer = static_cast<DoubleBaseType>(lhs[index]) * rhs + carry;
+		carry = static_cast<BaseType>(buffer / BigInteger::Base);
+		result[index] = static_cast<BaseType>(buffer % BigInteger::Base);
 	}
 
-	#ifdef DEBUG_SUBTRACT
-	std::cout << "lh_obj: " << *lh_obj << "; rh_obj: " << *rh_obj << std::endl;
-	#endif
+	return carry;
+}
 
-	if(lhs.sign == rhs.sign)
+// result = lhs / rhs for a divisor that fits in BaseType, result may alias
+// lhs, returns the remainder
+static BaseType divideSmall(BaseType* result, const BaseType* lhs, std::size_t size, BaseType rhs)
+{
+	DoubleBaseType buffer = 0;
+
+	for(std::size_t index = size; index-- > 0;)
 	{
-		#ifdef DEBUG_SUBTRACT
-		std::cout << "sign EQUAL" << std::endl;
-		#endif
+		buffer = buffer * BigInteger::Base + lhs[index];
+		result[index] = static_cast<BaseType>(buffer / rhs);
+		buffer %= rhs;
+	}
 
-		// duplicate the longer one, and ignore if it's itself
-		if(lh_obj != this)
-			operator = (*lh_obj);
+	return static_cast<BaseType>(buffer);
+}
 
-		#ifdef DEBUG_SUBTRACT
-		std::cout << "lh_obj copy complete" << std::endl;
-		#endif
+// knuth's algorithm D, quotient gets lh_size-rh_size+1 limbs and remainder
+// gets rh_size limbs, requires lh_size >= rh_size >= 2 and a normalized rhs
+static void divideLimbs(BaseType* quotient, BaseType* remainder, const BaseType* lhs, std::size_t lh_size, const BaseType* rhs, std::size_t rh_size)
+{
+	// normalize, so that the top limb of the divisor is at least Base/2
+	BaseType factor = static_cast<BaseType>(BigInteger::Base / (static_cast<DoubleBaseType>(rhs[rh_size-1]) + 1));
+	std::vector<BaseType> u(lh_size+1), v(rh_size);
+	u[lh_size] = multiplySmall(u.data(), lhs, lh_size, factor);
+	multiplySmall(v.data(), rhs, rh_size, factor);
 
-		BaseType carry = 0, buffer;
-		bool needCarry;
-		// iterate through rh_obj, add with lh_obj, and store into *this
-		for(std::vector<int>::size_type index = 0; index<rh_obj->storage.size() || carry!=0; index++)
+	const BaseType top = v[rh_size-1], second = v[rh_size-2];
+	DoubleBaseType numerator, estimate, rest, product, subtrahend;
+	BaseType carry, borrow;
+
+	for(std::size_t shift = lh_size-rh_size+1; shift-- > 0;)
+	{
+		BaseType* window = u.data() + shift;
+
+		// estimate the quotient limb from the top two limbs, then refine it
+		// with the third, after which it is at most one too large
+		numerator = static_cast<DoubleBaseType>(window[rh_size]) * BigInteger::Base + window[rh_size-1];
+		estimate = numerator / top;
+		rest = numerator % top;
+		while(estimate >= BigInteger::Base || estimate * second > rest * BigInteger::Base + window[rh_size-2])
 		{
-			buffer = lh_obj->storage[index];
+			estimate--;
+			rest += top;
+			if(rest >= BigInteger::Base)
+				break;
+		}
 
-			needCarry = false;
+		// multiply and subtract
+		carry = borrow = 0;
+		for(std::size_t index = 0; index < rh_size; index++)
+		{
+			product = estimate * v[index] + carry;
+			carry = static_cast<BaseType>(product / BigInteger::Base);
+			subtrahend = product % BigInteger::Base + borrow;
 
-			// perform the actual subtraction
-			if(index < rh_obj->storage.size())
+			// wrap first, since base type is unsigned
+			if(window[index] < subtrahend)
 			{
-				// wrap first, since base type is unsigned
-				if(lh_obj->storage[index] < rh_obj->storage[index]+carry)
-				{
-					buffer += Base;
-					needCarry = true;
-				}
-
-				buffer -= rh_obj->storage[index] + carry;
+				window[index] = static_cast<BaseType>(window[index] + BigInteger::Base - subtrahend);
+				borrow = 1;
 			}
 			else
 			{
-				if(lh_obj->storage[index] == 0)
-				{
-					buffer += Base;
-					needCarry = true;
-				}
-
-				buffer -= carry;
+				window[index] = static_cast<BaseType>(window[index] - subtrahend);
+				borrow = 0;
 			}
+		}
+
+		subtrahend = static_cast<DoubleBaseType>(carry) + borrow;
+		if(window[rh_size] < subtrahend)
+		{
+			// the estimate was one too large, add the divisor back
+			window[rh_size] = static_cast<BaseType>(window[rh_size] + BigInteger::Base - subtrahend);
+			estimate--;
+			window[rh_size] += addLimbs(window, window, rh_size, v.data(), rh_size);
+		}
+		else
+			window[rh_size] = static_cast<BaseType>(window[rh_size] - subtrahend);
+
+		quotient[shift] = static_cast<BaseType>(estimate);
+	}
+
+	// undo the normalization on what is left
+	divideSmall(remainder, u.data(), rh_size, factor);
+}
+
+// result += value * Base^offset, the carry is run through the rest of the
+// result, returns the carry out of the top limb
+static BaseType addLimbsAt(BaseType* result, std::size_t size, std::size_t offset, const BaseType* value, std::size_t value_size)
+{
+	return addLimbs(result+offset, result+offset, size-offset, value, value_size);
+}
+
+// result = |lhs - rhs| over lh_size limbs, requires lh_size >= rh_size,
+// returns 1 if lhs >= rhs and -1 otherwise
+static int differenceLimbs(BaseType* result, const BaseType* lhs, std::size_t lh_size, const BaseType* rhs, std::size_t rh_size)
+{
+	// the operands may carry leading zeros here, so compare them padded
+	int order = 0;
+	for(std::size_t index = lh_size; index-- > rh_size && order == 0;)
+	{
+		if(lhs[index] != 0)
+			order = 1;
+	}
+	for(std::size_t index = rh_size; index-- > 0 && order == 0;)
+	{
+		if(lhs[index] != rhs[index])
+			order = (lhs[index] > rhs[index]) ? 1 : -1;
+	}
+
+	if(order >= 0)
+	{
+		subtractLimbs(result, lhs, lh_size, rhs, rh_size);
+		return 1;
+	}
+
+	// lhs < rhs, so the limbs of lhs beyond rh_size are all zero
+	subtractLimbs(result, rhs, rh_size, lhs, rh_size);
+	for(std::size_t index = rh_size; index < lh_size; index++)
+		result[index] = 0;
+	return -1;
+}
+
+// scratch limbs karatsubaLimbs() needs when the longer operand has size limbs
+static std::size_t karatsubaScratchSize(std::size_t size)
+{
+	if(size < BigInteger::KaratsubaThreshold)
+		return 0;
+
+	std::size_t half = (size+1)/2;
+	return 6*half + 1 + karatsubaScratchSize(half);
+}
+
+// result = lhs * rhs, requires lh_size >= rh_size, result holds
+// lh_size+rh_size limbs and must not alias the operands or the scratch
+static void karatsubaLimbs(BaseType* result, const BaseType* lhs, std::size_t lh_size, const BaseType* rhs, std::size_t rh_size, BaseType* scratch)
+{
+	if(rh_size < BigInteger::KaratsubaThreshold)
+	{
+		multiplyLimbs(result, lhs, lh_size, rhs, rh_size);
+		return;
+	}
 
-			// store back
-			storage[index] = buffer;
+	std::size_t half = (lh_size+1)/2;
 
-			// refresh the carry
-			carry = (needCarry)?1:0;
+	if(rh_size <= half)
+	{
+		// uneven operands, slice lhs into rh_size pieces and multiply each one
+		BaseType* product = scratch;
+		std::size_t piece;
+
+		for(std::size_t index = 0; index < lh_size+rh_size; index++)
+			result[index] = 0;
+
+		for(std::size_t offset = 0; offset < lh_size; offset += rh_size)
+		{
+			piece = (lh_size-offset < rh_size) ? lh_size-offset : rh_size;
+			if(piece == rh_size)
+				karatsubaLimbs(product, lhs+offset, piece, rhs, rh_size, scratch+2*rh_size);
+			else
+				karatsubaLimbs(product, rhs, rh_size, lhs+offset, piece, scratch+2*rh_size);
+			addLimbsAt(result, lh_size+rh_size, offset, product, piece+rh_size);
 		}
+
+		return;
 	}
+
+	// split as lhs = a1*Base^half + a0, rhs = b1*Base^half + b0
+	const BaseType *a0 = lhs, *a1 = lhs+half, *b0 = rhs, *b1 = rhs+half;
+	std::size_t a1_size = lh_size-half, b1_size = rh_size-half;
+	BaseType *da = scratch, *db = scratch+half, *middle = scratch+2*half, *sum = scratch+4*half;
+	BaseType *next = scratch+6*half+1;
+
+	// a0*b0 and a1*b1 go straight into their final places
+	karatsubaLimbs(result, a0, half, b0, half, next);
+	karatsubaLimbs(result+2*half, a1, a1_size, b1, b1_size, next);
+
+	// (a0-a1)*(b0-b1) = a0*b0 + a1*b1 - (a0*b1 + a1*b0)
+	int signs = differenceLimbs(da, a0, half, a1, a1_size) * differenceLimbs(db, b0, half, b1, b1_size);
+	karatsubaLimbs(middle, da, half, db, half, next);
+
+	// sum = a0*b0 + a1*b1 -/+ |a0-a1|*|b0-b1|
+	for(std::size_t index = 0; index < 2*half; index++)
+		sum[index] = result[index];
+	sum[2*half] = 0;
+	addLimbs(sum, sum, 2*half+1, result+2*half, a1_size+b1_size);
+	if(signs > 0)
+		subtractLimbs(sum, sum, 2*half+1, middle, 2*half);
 	else
+		addLimbs(sum, sum, 2*half+1, middle, 2*half);
+
+	// the cross term can't reach past the end of the product
+	std::size_t sum_size = 2*half+1;
+	while(sum_size > 0 && sum[sum_size-1] == 0)
+		sum_size--;
+	addLimbsAt(result, lh_size+rh_size, half, sum, sum_size);
+}
+
+// result = operand^2, result holds 2*size limbs and must not alias the
+// operand or the scratch, which needs karatsubaScratchSize(size) limbs
+static void karatsubaSquareLimbs(BaseType* result, const BaseType* operand, std::size_t size, BaseType* scratch)
+{
+	if(size < BigInteger::KaratsubaSquareThreshold)
 	{
-		#ifdef DEBUG_SUBTRACT
-		std::cout << "sign DIFFERENT" << std::endl;
-		#endif
+		squareLimbs(result, operand, size);
+		return;
+	}
+
+	// split as operand = a1*Base^half + a0, three half sized squares
+	std::size_t half = (size+1)/2;
+	const BaseType *a0 = operand, *a1 = operand+half;
+	std::size_t a1_size = size-half;
+	BaseType *da = scratch, *middle = scratch+2*half, *sum = scratch+4*half;
+	BaseType *next = scratch+6*half+1;
+
+	karatsubaSquareLimbs(result, a0, half, next);
+	karatsubaSquareLimbs(result+2*half, a1, a1_size, next);
+	differenceLimbs(da, a0, half, a1, a1_size);
+	karatsubaSquareLimbs(middle, da, half, next);
+
+	// sum = a0^2 + a1^2 - (a0-a1)^2 = 2*a0*a1
+	for(std::size_t index = 0; index < 2*half; index++)
+		sum[index] = result[index];
+	sum[2*half] = 0;
+	addLimbs(sum, sum, 2*half+1, result+2*half, 2*a1_size);
+	subtractLimbs(sum, sum, 2*half+1, middle, 2*half);
+
+	std::size_t sum_size = 2*half+1;
+	while(sum_size > 0 && sum[sum_size-1] == 0)
+		sum_size--;
+	addLimbsAt(result, 2*size, half, sum, sum_size);
+}
+
+//
+// thread pool
+//
+// Every worker pushes and pops its own tasks at the back of its deque and
+// steals from the front of the others, so the big, early tasks of a
+// recursion are the ones that move. A thread waiting for its tasks runs
+// queued ones meanwhile, so the nested fork/join of the recursive
+// multiplications can't deadlock, and sleeps while there are none. Threads
+// outside the pool share one deque.
+//
+class TaskGroup;
+
+struct PoolTask
+{
+	std::function<void()> work;
+	TaskGroup* group;
+};
+
+class WorkPool
+{
+public:
+	static WorkPool& instance();
+	~WorkPool();
+
+	// workers plus the caller, which always helps
+	void start(unsigned int);
+	unsigned int threads() const;
+	bool active() const;
+
+	void push(const PoolTask&);
+	// runs one queued task, false when there was none
+	bool runOne();
+	// blocks until pending drops to zero or there is work to help with,
+	// finished() wakes the sleepers once a group is done
+	void sleep(const std::atomic<std::size_t>&);
+	void finished();
+
+private:
+	struct Queue
+	{
+		std::mutex lock;
+		std::deque<PoolTask> tasks;
+	};
+
+	WorkPool();
+	void stop();
+	void work(std::size_t);
+	bool take(std::size_t, PoolTask&);
+	void run(PoolTask&);
+
+	std::vector<std::thread> workers;
+	// one per worker and the shared one last, a deque keeps them in place
+	std::deque<Queue> queues;
+	std::atomic<std::size_t> queued;
+	std::atomic<bool> stopping;
+	std::mutex sleepLock;
+	std::condition_variable wake;
+};
+
+// tasks spawned together, wait() returns once all of them ran and
+// rethrows the first exception one of them threw
+class TaskGroup
+{
+public:
+	TaskGroup() : pending(0) {}
+
+	void spawn(const std::function<void()>&);
+	void wait();
+	void finish(const std::exception_ptr&);
+
+private:
+	std::atomic<std::size_t> pending;
+	std::mutex errorLock;
+	std::exception_ptr error;
+};
+
+// the queue of the calling thread, outside threads share the last one
+static thread_local std::size_t poolWorker = static_cast<std::size_t>(-1);
+
+WorkPool::WorkPool() : queued(0), stopping(false)
+{
+	queues.resize(1);
+}
+
+WorkPool::~WorkPool()
+{
+	stop();
+}
+
+WorkPool& WorkPool::instance()
+{
+	static WorkPool pool;
+	return pool;
+}
+
+void WorkPool::start(unsigned int threads)
+{
+	stop();
+	std::size_t count = (threads > 1) ? threads-1 : 0;
+	queues.clear();
+	queues.resize(count+1);
+	stopping = false;
+	for(std::size_t index = 0; index < count; index++)
+		workers.push_back(std::thread(&WorkPool::work, this, index));
+}
+
+void WorkPool::stop()
+{
+	{
+		std::lock_guard<std::mutex> guard(sleepLock);
+		stopping = true;
+	}
+	wake.notify_all();
+	for(std::size_t index = 0; index < workers.size(); index++)
+		workers[index].join();
+	workers.clear();
+}
+
+unsigned int WorkPool::threads() const
+{
+	return static_cast<unsigned int>(workers.size()) + 1;
+}
 
-		if(lh_obj->sign == BigInteger::POSITIVE)
+bool WorkPool::active() const
+{
+	return !workers.empty();
+}
+
+void WorkPool::push(const PoolTask& task)
+{
+	std::size_t index = (poolWorker < workers.size()) ? poolWorker : workers.size();
+	{
+		std::lock_guard<std::mutex> guard(queues[index].lock);
+		queues[index].tasks.push_back(task);
+	}
+	queued++;
+
+	// taking the lock orders the count before a worker's check for it
+	{
+		std::lock_guard<std::mutex> guard(sleepLock);
+	}
+	wake.notify_one();
+}
+
+bool WorkPool::take(std::size_t self, PoolTask& task)
+{
+	// the newest task of the own deque, then the oldest of the others
+	std::size_t count = queues.size();
+	for(std::size_t offset = 0; offset < count; offset++)
+	{
+		std::size_t index = (self + offset) % count;
+		std::lock_guard<std::mutex> guard(queues[index].lock);
+		std::deque<PoolTask>& tasks = queues[index].tasks;
+		if(tasks.empty())
+			continue;
+
+		if(offset == 0 && self < workers.size())
 		{
-			// +LARGE -SMALL
-			add(*lh_obj, -(*rh_obj));
+			task = tasks.back();
+			tasks.pop_back();
 		}
 		else
 		{
-			// -LARGE +SMALL
+			task = tasks.front();
+			tasks.pop_front();
+		}
+		queued--;
+		return true;
+	}
+	return false;
+}
+
+void WorkPool::run(PoolTask& task)
+{
+	// the task may belong to another thread's arena scope, its limbs come
+	// from the heap so that they can be handed over and freed anywhere
+	LimbAllocatorScope scope(HeapLimbAllocator::instance());
+	std::exception_ptr error;
+	try
+	{
+		task.work();
+	}
+	catch(...)
+	{
+		error = std::current_exception();
+	}
+	task.group->finish(error);
+}
+
+void WorkPool::sleep(const std::atomic<std::size_t>& pending)
+{
+	std::unique_lock<std::mutex> guard(sleepLock);
+	while(pending != 0 && queued == 0)
+		wake.wait(guard);
+}
+
+void WorkPool::finished()
+{
+	// the lock orders the count before a sleeper's check for it
+	{
+		std::lock_guard<std::mutex> guard(sleepLock);
+	}
+	wake.notify_all();
+}
+
+bool WorkPool::runOne()
+{
+	PoolTask task;
+	if(!take((poolWorker < workers.size()) ? poolWorker : workers.size(), task))
+		return false;
+	run(task);
+	return true;
+}
+
+void WorkPool::work(std::size_t index)
+{
+	poolWorker = index;
+	while(true)
+	{
+		PoolTask task;
+		if(take(index, task))
+		{
+			run(task);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> guard(sleepLock);
+		if(stopping)
+			return;
+		if(queued == 0)
+			wake.wait(guard);
+	}
+}
+
+void TaskGroup::spawn(const std::function<void()>& work)
+{
+	PoolTask task;
+	task.work = work;
+	task.group = this;
+	pending++;
+	WorkPool::instance().push(task);
+}
+
+void TaskGroup::finish(const std::exception_ptr& failure)
+{
+	if(failure)
+	{
+		std::lock_guard<std::mutex> guard(errorLock);
+		if(!error)
+			error = failure;
+	}
+	// the group may be gone once the count is zero, the pool is not
+	if(--pending == 0)
+		WorkPool::instance().finished();
+}
+
+void TaskGroup::wait()
+{
+	WorkPool& pool = WorkPool::instance();
+	// help while there is work, otherwise sleep until there is some or the
+	// last task of the group is done
+	while(pending != 0)
+	{
+		if(!pool.runOne())
+			pool.sleep(pending);
+	}
+	if(error)
+		std::rethrow_exception(error);
+}
+
+// runs the tasks, spread over the pool when parallel is set and the pool
+// has threads, otherwise one after the other on the calling thread
+static void runTasks(const std::function<void()>* tasks, std::size_t count, bool parallel)
+{
+	if(!parallel || !WorkPool::instance().active())
+	{
+		for(std::size_t index = 0; index < count; index++)
+			tasks[index]();
+		return;
+	}
+
+	TaskGroup group;
+	for(std::size_t index = 1; index < count; index++)
+		group.spawn(tasks[index]);
+	std::exception_ptr failure;
+	try
+	{
+		tasks[0]();
+	}
+	catch(...)
+	{
+		failure = std::current_exception();
+	}
+	group.wait();
+	if(failure)
+		std::rethrow_exception(failure);
+}
+
+#if !defined(BIGINTEGER_LIMB_BITS)
+std::size_t BigInteger::ParallelThreshold = 4000;
+#elif BIGINTEGER_LIMB_BITS == 32
+std::size_t BigInteger::ParallelThreshold = 2000;
+#else
+std::size_t BigInteger::ParallelThreshold = 1000;
+#endif
+
+void BigInteger::setThreads(unsigned int threads)
+{
+	WorkPool::instance().start(threads);
+}
+
+unsigned int BigInteger::threads()
+{
+	return WorkPool::instance().threads();
+}
+
+// whether a product with a shorter operand of size limbs is split up
+static bool parallelFor(std::size_t size)
+{
+	return size >= BigInteger::ParallelThreshold && WorkPool::instance().active();
+}
+
+//
+// number theoretic transform
+//
+// Products are convolved modulo three NTT friendly primes and put back
+// together with the chinese remainder theorem. Decimal limbs are used as
+// they are, binary limbs are cut into 32 bit pieces. A convolution term is
+// bounded by the shorter operand's piece count times (NTTPieceBase-1)^2, and
+// that has to stay below the product of the primes, about 2^85.6.
+//
+#if !defined(BIGINTEGER_LIMB_BITS)
+static const unsigned int NTTPiecesPerLimb = 1;
+static const unsigned long long NTTPieceBase = BigInteger::Base;
+#else
+static const unsigned int NTTPiecesPerLimb = BIGINTEGER_LIMB_BITS/32;
+static const unsigned long long NTTPieceBase = 1ULL << 32;
+#endif
+
+// 5*2^25+1, 7*2^26+1 and 45*2^24+1, all of them allow 2^24 point transforms
+static const unsigned int NTTPrime1 = 167772161, NTTPrime2 = 469762049, NTTPrime3 = 754974721;
+static const std::size_t NTTMaxLength = static_cast<std::size_t>(1) << 24;
+#if !defined(BIGINTEGER_LIMB_BITS)
+static const std::size_t NTTMaxShortPieces = NTTMaxLength;
+#else
+static const std::size_t NTTMaxShortPieces = static_cast<std::size_t>(1) << 21;
+#endif
+
+#if !defined(BIGINTEGER_LIMB_BITS)
+std::size_t BigInteger::NTTThreshold = 40000;
+#elif BIGINTEGER_LIMB_BITS == 32
+std::size_t BigInteger::NTTThreshold = 60000;
+#else
+std::size_t BigInteger::NTTThreshold = 30000;
+#endif
+
+// IOBase groups below which the parser folds the digits in one at a time,
+// and limbs below which the formatter peels the groups off one at a time
+static const std::size_t ParseBasecaseGroups = 64;
+static const std::size_t ConvertBasecaseLimbs = 32;
+
+// high:low = lhs * rhs, without relying on a 128 bit type
+static void multiplyWide(unsigned long long lhs, unsigned long long rhs, unsigned long long& high, unsigned long long& low)
+{
+	const unsigned long long mask = 0xffffffffULL;
+	unsigned long long p00 = (lhs & mask) * (rhs & mask), p01 = (lhs & mask) * (rhs >> 32);
+	unsigned long long p10 = (lhs >> 32) * (rhs & mask), p11 = (lhs >> 32) * (rhs >> 32);
+	unsigned long long middle = (p00 >> 32) + (p01 & mask) + (p10 & mask);
+
+	low = (middle << 32) | (p00 & mask);
+	high = p11 + (p01 >> 32) + (p10 >> 32) + (middle >> 32);
+}
+
+static unsigned int powerMod(unsigned long long base, unsigned long long exponent, unsigned int prime)
+{
+	unsigned long long result = 1;
+	for(base %= prime; exponent > 0; exponent >>= 1)
+	{
+		if(exponent & 1)
+			result = result * base % prime;
+		base = base * base % prime;
+	}
+	return static_cast<unsigned int>(result);
+}
+
+// butterflies first to last of a stage, numbered across its blocks
+template<unsigned int Prime>
+static void nttButterflies(unsigned int* values, const unsigned int* twiddles, std::size_t half, std::size_t first, std::size_t last)
+{
+	std::size_t block = (first/half) * 2*half, index = first % half;
+	for(; first < last; block += 2*half, index = 0)
+	{
+		std::size_t end = std::min(half, index + (last-first));
+		for(first += end-index; index < end; index++)
+		{
+			unsigned int u = values[block+index];
+			unsigned int v = static_cast<unsigned int>(static_cast<unsigned long long>(values[block+index+half]) * twiddles[index] % Prime);
+			values[block+index] = (u+v >= Prime) ? u+v-Prime : u+v;
+			values[block+index+half] = (u >= v) ? u-v : u+Prime-v;
+		}
+	}
+}
+
+// butterflies per task when a stage is spread over the pool
+static const std::size_t NTTParallelChunk = static_cast<std::size_t>(1) << 15;
+
+// in place radix-2 transform, the prime is a template argument so that the
+// reductions compile to multiplications; parallel spreads every stage over
+// the pool
+template<unsigned int Prime, unsigned int Root>
+static void nttTransform(unsigned int* values, std::size_t size, bool inverse, bool parallel)
+{
+	// bit reversal permutation
+	for(std::size_t index = 1, reversed = 0; index < size; index++)
+	{
+		std::size_t bit = size >> 1;
+		for(; reversed & bit; bit >>= 1)
+			reversed ^= bit;
+		reversed ^= bit;
+
+		if(index < reversed)
+		{
+			unsigned int temp = values[index];
+			values[index] = values[reversed];
+			values[reversed] = temp;
+		}
+	}
+
+	std::vector<unsigned int> twiddles(size/2 + 1);
+	for(std::size_t length = 2; length <= size; length <<= 1)
+	{
+		std::size_t half = length/2;
+		unsigned long long step = powerMod(Root, (Prime-1)/length, Prime);
+		if(inverse)
+			step = powerMod(step, Prime-2, Prime);
+
+		twiddles[0] = 1;
+		for(std::size_t index = 1; index < half; index++)
+			twiddles[index] = static_cast<unsigned int>(twiddles[index-1] * step % Prime);
+
+		// the stages depend on each other, each one joins its chunks
+		std::size_t chunks = parallel ? std::min<std::size_t>(WorkPool::instance().threads(), size/2/NTTParallelChunk) : 1;
+		if(chunks < 2)
+		{
+			nttButterflies<Prime>(values, twiddles.data(), half, 0, size/2);
+			continue;
+		}
+
+		std::vector<std::function<void()> > tasks(chunks);
+		for(std::size_t chunk = 0; chunk < chunks; chunk++)
+		{
+			std::size_t first = size/2 * chunk/chunks, last = size/2 * (chunk+1)/chunks;
+			const unsigned int* factors = twiddles.data();
+			tasks[chunk] = [=]() { nttButterflies<Prime>(values, factors, half, first, last); };
+		}
+		runTasks(tasks.data(), chunks, true);
+	}
+
+	if(inverse)
+	{
+		unsigned long long scale = powerMod(size, Prime-2, Prime);
+		for(std::size_t index = 0; index < size; index++)
+			values[index] = static_cast<unsigned int>(values[index] * scale % Prime);
+	}
+}
+
+// result = lhs (*) rhs modulo Prime, the inputs are zero padded to size,
+// passing the same vector twice squares it with one forward transform less
+template<unsigned int Prime, unsigned int Root>
+static void nttConvolve(std::vector<unsigned int>& result, const std::vector<unsigned int>& lhs, const std::vector<unsigned int>& rhs, std::size_t size, bool parallel)
+{
+	const bool squaring = (&lhs == &rhs);
+	std::vector<unsigned int> buffer;
+
+	// binary pieces can exceed the prime
+	std::function<void()> forward[2];
+	forward[0] = [&]()
+	{
+		result = lhs;
+		result.resize(size, 0);
+		for(std::size_t index = 0; index < size; index++)
+			result[index] %= Prime;
+		nttTransform<Prime, Root>(result.data(), size, false, parallel);
+	};
+	forward[1] = [&]()
+	{
+		buffer = rhs;
+		buffer.resize(size, 0);
+		for(std::size_t index = 0; index < size; index++)
+			buffer[index] %= Prime;
+		nttTransform<Prime, Root>(buffer.data(), size, false, parallel);
+	};
+	runTasks(forward, squaring ? 1 : 2, parallel);
+
+	const std::vector<unsigned int>& other = squaring ? result : buffer;
+	for(std::size_t index = 0; index < size; index++)
+		result[index] = static_cast<unsigned int>(static_cast<unsigned long long>(result[index]) * other[index] % Prime);
+	nttTransform<Prime, Root>(result.data(), size, true, parallel);
+}
+
+// cut limbs into NTT pieces, least significant first
+static void splitPieces(std::vector<unsigned int>& pieces, const BaseType* limbs, std::size_t size)
+{
+	pieces.resize(size*NTTPiecesPerLimb);
+	for(std::size_t index = 0; index < size; index++)
+	{
+		BaseType limb = limbs[index];
+		for(std::size_t piece = 0; piece < NTTPiecesPerLimb; piece++)
+		{
+			pieces[index*NTTPiecesPerLimb+piece] = static_cast<unsigned int>(limb % NTTPieceBase);
+			limb = static_cast<BaseType>(limb / NTTPieceBase);
+		}
+	}
+}
+
+//
+// actual functions
+//
+BigInteger::BigInteger() : sign(BigInteger::ZERO)
+{
+}
+
+BigInteger::BigInteger(const int& input)
+{
+	operator = (input);
+}
+
+BigInteger::BigInteger(const std::string& input)
+{
+	parse(input.data(), input.size());
+}
+
+BigInteger::BigInteger(const char* input)
+{
+	parse(input, std::strlen(input));
+}
+
+BigInteger::BigInteger(const char* input, std::size_t length)
+{
+	parse(input, length);
+}
+
+#if __cplusplus >= 201703L
+BigInteger::BigInteger(std::string_view input)
+{
+	parse(input.data(), input.size());
+}
+#endif
+
+BigInteger::BigInteger(const BigInteger& input) : sign(input.sign), storage(input.storage)
+{
+}
+
+BigInteger::BigInteger(BigInteger&& input) noexcept : sign(input.sign), storage(std::move(input.storage))
+{
+	// leave the source as a valid zero
+	input.storage.clear();
+	input.sign = BigInteger::ZERO;
+}
+
+// unary operator
+void BigInteger::operator - ()
+{
+	if(sign == BigInteger::POSITIVE)
+		sign = BigInteger::NEGATIVE;
+	else if(sign == BigInteger::NEGATIVE)
+		sign = BigInteger::POSITIVE;
+}
+
+BigInteger BigInteger::operator - () const
+{
+	BigInteger result(*this);
+	result.operator - ();
+	return result;
+}
+
+void BigInteger::operator ++ ()
+{
+	if(sign == BigInteger::NEGATIVE)
+	{
+		// -1 -> 0 is handled by removeTrailingZeros()
+		decrementMagnitude();
+	}
+	else
+	{
+		// 0 -> 1
+		incrementMagnitude();
+		sign = BigInteger::POSITIVE;
+	}
+}
+
+void BigInteger::operator ++ (int)
+{
+	operator ++ ();
+}
+
+void BigInteger::operator -- ()
+{
+	if(sign == BigInteger::POSITIVE)
+	{
+		// 1 -> 0 is handled by removeTrailingZeros()
+		decrementMagnitude();
+	}
+	else
+	{
+		// 0 -> -1
+		incrementMagnitude();
+		sign = BigInteger::NEGATIVE;
+	}
+}
+
+void BigInteger::operator -- (int)
+{
+	operator -- ();
+}
+
+// binary operator: arithmetic
+BigInteger BigInteger::operator + (const BigInteger& rhs) const &
+{
+	BigInteger result;
+	result.add(*this, rhs);
+	return result;
+}
+
+BigInteger BigInteger::operator - (const BigInteger& rhs) const &
+{
+	BigInteger result;
+	result.subtract(*this, rhs);
+	return result;
+}
+
+// a temporary on the left, as in a*b + c, takes the result in its own storage
+BigInteger BigInteger::operator + (const BigInteger& rhs) &&
+{
+	add(*this, rhs);
+	return std::move(*this);
+}
+
+BigInteger BigInteger::operator - (const BigInteger& rhs) &&
+{
+	subtract(*this, rhs);
+	return std::move(*this);
+}
+
+BigInteger BigInteger::operator * (const BigInteger& rhs) const
+{
+	BigInteger result;
+	result.multiply(*this, rhs);
+	return result;
+}
+
+BigInteger BigInteger::square() const
+{
+	BigInteger result;
+	result.multiply(*this, *this);
+	return result;
+}
+
+BigInteger BigInteger::operator / (const BigInteger& rhs) const
+{
+	BigInteger result;
+	result.divide(*this, rhs);
+	return result;
+}
+
+BigInteger BigInteger::operator % (const BigInteger& rhs) const
+{
+	BigInteger result;
+	result.modulus(*this, rhs);
+	return result;
+}
+
+void BigInteger::divmod(const BigInteger& lhs, const BigInteger& rhs, BigInteger& quotient, BigInteger& remainder)
+{
+	if(rhs.isZero())
+		throw "BigInteger::divmod -> divide by zero";
+
+	// both results are built aside, quotient and remainder may alias the operands
+	BigInteger q, r;
+	if(lhs.isZero() || q.compareMagnitude(lhs, rhs) == BigInteger::LESS)
+		r = lhs;
+	else
+	{
+		// truncate toward zero, the remainder takes the sign of the dividend
+		q.divideMagnitude(lhs, rhs, r);
+		q.sign = static_cast<Sign>(lhs.sign * rhs.sign);
+		if(!r.isZero())
+			r.sign = lhs.sign;
+	}
+
+	quotient.storage.swap(q.storage);
+	quotient.sign = q.sign;
+	remainder.storage.swap(r.storage);
+	remainder.sign = r.sign;
+}
+
+// binary operator: arithmetic (continue)
+BigInteger& BigInteger::operator += (const BigInteger& rhs)
+{
+	add(*this, rhs);
+	return *this;
+}
+
+BigInteger& BigInteger::operator -= (const BigInteger& rhs)
+{
+	subtract(*this, rhs);
+	return *this;
+}
+BigInteger& BigInteger::operator *= (const BigInteger& rhs)
+{
+	multiply(*this, rhs);
+	return *this;
+}
+
+BigInteger& BigInteger::operator *= (const int& rhs)
+{
+	if(rhs == 0 || isZero())
+		return operator = (0);
+
+	unsigned long long magnitude = (rhs < 0) ? -static_cast<long long>(rhs) : rhs;
+	if(magnitude >= BigInteger::Base)
+	{
+		// the multiplier doesn't fit in a limb
+		multiply(*this, BigInteger(rhs));
+		return *this;
+	}
+
+	multiplyBySmall(static_cast<BaseType>(magnitude));
+	if(rhs < 0)
+		operator - ();
+
+	return *this;
+}
+
+BigInteger& BigInteger::operator /= (const BigInteger& rhs)
+{
+	divide(*this, rhs);
+	return *this;
+}
+
+BigInteger& BigInteger::operator /= (const int& rhs)
+{
+	if(rhs == 0)
+		throw "BigInteger::operator/=(const int&) -> divide by zero";
+
+	// any int fits in BaseType, so this is a single pass over the limbs
+	divideBySmall(static_cast<BaseType>((rhs < 0) ? -static_cast<long long>(rhs) : rhs));
+	if(rhs < 0)
+		operator - ();
+
+	return *this;
+}
+
+BigInteger& BigInteger::operator %= (const BigInteger& rhs)
+{
+	modulus(*this, rhs);
+	return *this;
+}
+
+// binary operator: comparison
+bool BigInteger::operator > (const BigInteger& rhs) const
+{
+	return compare(*this, rhs) == BigInteger::GREATER;
+}
+
+bool BigInteger::operator == (const BigInteger& rhs) const
+{
+	return compare(*this, rhs) == BigInteger::EQUAL;
+}
+
+bool BigInteger::operator < (const BigInteger& rhs) const
+{
+	return compare(*this, rhs) == BigInteger::LESS;
+}
+
+bool BigInteger::operator >= (const BigInteger& rhs) const
+{
+	return operator > (rhs) || operator == (rhs);
+}
+
+bool BigInteger::operator != (const BigInteger& rhs) const
+{
+	return !operator == (rhs);
+}
+
+bool BigInteger::operator <= (const BigInteger& rhs) const
+{
+	return operator < (rhs) || operator == (rhs);
+}
+
+// binary operator: stream and memroy operation
+BigInteger& BigInteger::operator = (const BigInteger& rhs)
+{
+	// the support functions assign from their own operands
+	if(this == &rhs)
+		return *this;
+
+	// copy sign
+	sign = rhs.sign;
+
+	// deep copy, the existing capacity is reused when it is large enough
+	storage.assign(rhs.storage.begin(), rhs.storage.end());
+
+	return *this;
+}
+
+BigInteger& BigInteger::operator = (BigInteger&& rhs) noexcept
+{
+	if(this == &rhs)
+		return *this;
+
+	// take over the limbs, the source is left as zero
+	sign = rhs.sign;
+	storage.swap(rhs.storage);
+	rhs.storage.clear();
+	rhs.sign = BigInteger::ZERO;
+
+	return *this;
+}
+
+BigInteger& BigInteger::operator = (const int& rhs)
+{
+	// widen first, so negating INT_MIN doesn't overflow
+	long long temp = rhs;
+
+	// empty the storage, the capacity is kept
+	storage.clear();
+
+	// register the sign of default value
+	if(temp == 0)
+		sign = BigInteger::ZERO;
+	else if(temp > 0)
+		sign = BigInteger::POSITIVE;
+	else
+	{
+		sign = BigInteger::NEGATIVE;
+		temp *= -1;
+	}
+
+	while(temp > 0)
+	{
+		storage.push_back(static_cast<BaseType>(temp%BigInteger::Base));
+		temp /= BigInteger::Base;
+	}
+
+	return *this;
+}
+
+std::ostream& operator << (std::ostream& stream, const BigInteger& rhs)
+{
+	// format into a buffer and hand it over in one write, small values
+	// stay on the stack
+	char local[64];
+	std::vector<char> heap;
+	std::size_t length = rhs.charsLength();
+	char* buffer = local;
+	if(length > sizeof(local))
+	{
+		heap.resize(length);
+		buffer = heap.data();
+	}
+
+	char* end = rhs.toChars(buffer, buffer + length);
+	stream.write(buffer, end - buffer);
+
+	return stream;
+}
+
+std::size_t BigInteger::charsLength() const
+{
+	if(isZero())
+		return 1;
+
+	// a sign only where toChars() writes one
+	std::size_t length = (sign == NEGATIVE) ? 1 : 0;
+	#ifdef FORCE_SHOW_POSITIVE
+	length = 1;
+	#endif
+	BaseType top = storage.back();
+
+#if !defined(BIGINTEGER_LIMB_BITS)
+	// the digit count is exact, every limb below the top one has
+	// BaseMagnitude10 digits
+	length += (storage.size()-1) * BaseMagnitude10;
+	for(; top > 0; top /= 10)
+		length++;
+#else
+	// 2^(bits-1) <= |value| < 2^bits has at most floor(bits*log10(2)) + 1
+	// digits, at most one more than it needs. The floor comes from the
+	// bounds 1292913986/2^32 < log10(2) < 1292913987/2^32, split so that
+	// the products can't overflow; where the two disagree the exact count
+	// is taken instead.
+	unsigned long long bits = static_cast<unsigned long long>(storage.size()-1) * BIGINTEGER_LIMB_BITS;
+	for(; top > 0; top >>= 1)
+		bits++;
+
+	unsigned long long bounds[2] = { 1292913986ULL, 1292913987ULL };
+	for(std::size_t index = 0; index < 2; index++)
+		bounds[index] = ((bits >> 16) * bounds[index] + (((bits & 0xffff) * bounds[index]) >> 16)) >> 16;
+	if(bounds[0] == bounds[1])
+		length += static_cast<std::size_t>(bounds[0]) + 1;
+	else
+		length += static_cast<std::size_t>(getPreciseMagnitude());
+#endif
+
+	return length;
+}
+
+char* BigInteger::toChars(char* first, char* last) const
+{
+	if(isZero())
+	{
+		if(last - first < 1)
+			throw "BigInteger::toChars -> buffer too small";
+		*first++ = '0';
+		return first;
+	}
+
+	std::size_t prefix = 0;
+	char signChar = 0;
+	if(sign == NEGATIVE)
+		signChar = '-';
+	#ifdef FORCE_SHOW_POSITIVE
+	else
+		signChar = '+';
+	#endif
+	if(signChar != 0)
+		prefix = 1;
+
+#if !defined(BIGINTEGER_LIMB_BITS)
+	// the limbs are the decimal groups already
+	const BaseType* groups = storage.data();
+	std::size_t count = storage.size();
+#else
+	std::vector<BaseType> buffer;
+	std::vector<char> digits;
+	const BaseType* groups = 0;
+	std::size_t count = 0;
+	if(storage.size() <= ConvertBasecaseLimbs)
+	{
+		toDecimalGroups(buffer);
+		groups = buffer.data();
+		count = buffer.size();
+	}
+	else
+	{
+		// long values are split by cached powers of IOBase, the digits come
+		// out padded to a power of two count of groups
+		toDecimalDigits(digits);
+		std::size_t skip = 0;
+		while(digits[skip] == '0')
+			skip++;
+
+		std::size_t length = digits.size() - skip;
+		if(static_cast<std::size_t>(last - first) < prefix + length)
+			throw "BigInteger::toChars -> buffer too small";
+		if(prefix != 0)
+			*first++ = signChar;
+		std::memcpy(first, digits.data() + skip, length);
+		return first + length;
+	}
+#endif
+
+	// the top group goes without padding
+	char top[IOBaseMagnitude10];
+	std::size_t top_length = 0;
+	for(BaseType group = groups[count-1]; group > 0; group /= 10)
+		top[IOBaseMagnitude10 - ++top_length] = static_cast<char>('0' + group%10);
+
+	std::size_t length = top_length + (count-1) * IOBaseMagnitude10;
+	if(static_cast<std::size_t>(last - first) < prefix + length)
+		throw "BigInteger::toChars -> buffer too small";
+
+	if(prefix != 0)
+		*first++ = signChar;
+	std::memcpy(first, top + IOBaseMagnitude10 - top_length, top_length);
+	first += top_length;
+
+	for(std::size_t index = count-1; index-- > 0;)
+	{
+		BaseType group = groups[index];
+		for(std::size_t digit = IOBaseMagnitude10; digit-- > 0; group /= 10)
+			first[digit] = static_cast<char>('0' + group%10);
+		first += IOBaseMagnitude10;
+	}
+
+	return first;
+}
+
+bool BigInteger::iseven()
+{
+	if(isZero() || storage.front()%2==0)
+		return true;
+	else
+		return false;
+}
+
+bool BigInteger::iszero() const
+{
+	return isZero();
+}
+
+//
+// support functions
+//
+void BigInteger::add(const BigInteger& lhs, const BigInteger& rhs)
+{
+	#ifdef DEBUG_ADD
+	std::cout << "=====" << std::endl;
+	std::cout << "add() called" << std::endl;
+	#endif
+
+	if(lhs.sign == BigInteger::ZERO)
+	{
+		operator = (rhs);
+		return;
+	}
+	else if(rhs.sign == ZERO)
+	{
+		operator = (lhs);
+		return;
+	}
+
+	// keep the sign aside, *this may alias either operand
+	Sign resultSign;
+
+	if(lhs.sign == rhs.sign)
+	{
+		resultSign = lhs.sign;
+		addMagnitude(lhs, rhs);
+	}
+	else
+	{
+		// rearrange according to the magnitude
+		switch(compareMagnitude(lhs, rhs))
+		{
+			case EQUAL:
+				operator = (0);
+				return;
+			case GREATER:
+				// +LARGE -SMALL or -LARGE +SMALL
+				resultSign = lhs.sign;
+				subtractMagnitude(lhs, rhs);
+				break;
+			default:
+				// +SMALL -LARGE or -SMALL +LARGE
+				resultSign = rhs.sign;
+				subtractMagnitude(rhs, lhs);
+		}
+	}
+
+	sign = resultSign;
+
+	#ifdef DEBUG_ADD
+	std::cout << "add(): result is " << *this << std::endl;
+	std::cout << "=====" << std::endl;
+	#endif
+}
+
+void BigInteger::subtract(const BigInteger& lhs, const BigInteger& rhs)
+{
+	#ifdef DEBUG_SUBTRACT
+	std::cout << "=====" << std::endl;
+	std::cout << "subtract() called" << std::endl;
+	#endif
+
+	if(lhs.sign == ZERO)
+	{
+		#ifdef DEBUG_SUBTRACT
+		std::cout << "...lhs is ZERO" << std::endl;
+		#endif
+
+		operator = (rhs);
+		//*this = -(*this);
+		operator - ();
+		return;
+	}
+	else if(rhs.sign == ZERO)
+	{
+		#ifdef DEBUG_SUBTRACT
+		std::cout << "...rhs is ZERO" << std::endl;
+		#endif
+
+		operator = (lhs);
+		return;
+	}
+
+	// keep the sign aside, *this may alias either operand
+	Sign resultSign;
+
+	if(lhs.sign == rhs.sign)
+	{
+		#ifdef DEBUG_SUBTRACT
+		std::cout << "sign EQUAL" << std::endl;
+		#endif
+
+		// rearrange according to the magnitude
+		switch(compareMagnitude(lhs, rhs))
+		{
+			case EQUAL:
+				operator = (0);
+				return;
+			case GREATER:
+				resultSign = lhs.sign;
+				subtractMagnitude(lhs, rhs);
+				break;
+			default:
+				// negate the result when lhs and rhs are swapped
+				resultSign = (lhs.sign == POSITIVE) ? NEGATIVE : POSITIVE;
+				subtractMagnitude(rhs, lhs);
+		}
+	}
+	else
+	{
+		#ifdef DEBUG_SUBTRACT
+		std::cout << "sign DIFFERENT" << std::endl;
+		#endif
+
+		// +A -(-B) or -A -(+B)
+		resultSign = lhs.sign;
+		addMagnitude(lhs, rhs);
+	}
+
+	sign = resultSign;
+
+	#ifdef DEBUG_SUBTRACT
+	std::cout << "=====" << std::endl;
+	#endif
+}
+
+void BigInteger::multiply(const BigInteger& lhs, const BigInteger& rhs)
+{
+	#ifdef DEBUG_MULTIPLY
+	std::cout << "=====" << std::endl;
+	std::cout << "multiply() called" << std::endl;
+	#endif
+
+	// set as 0 if either of them is 0
+	if(lhs.isZero() || rhs.isZero())
+	{
+		operator = (0);
+		return;
+	}
+
+	Sign resultSign = static_cast<Sign>(lhs.sign * rhs.sign);
+
+	const BigInteger *lh_obj, *rh_obj;
+	// have the longer one on the left side
+	if(lhs.storage.size() < rhs.storage.size())
+	{
+		lh_obj = &rhs;
+		rh_obj = &lhs;
+	}
+	else
+	{
+		lh_obj = &lhs;
+		rh_obj = &rhs;
+	}
+
+	#ifdef DEBUG_MULTIPLY
+	std::cout << "lh_obj: " << *lh_obj << "; rh_obj: " << *rh_obj << std::endl;
+	#endif
+
+	std::size_t lh_size = lh_obj->storage.size(), rh_size = rh_obj->storage.size();
+
+	// x*x computes every cross product once, the methods below all see the
+	// square through their operands being the same object
+	const bool squaring = (&lhs == &rhs);
+
+	if(rh_size >= BigInteger::NTTThreshold && (lh_size+rh_size)*NTTPiecesPerLimb <= NTTMaxLength &&
+	   rh_size*NTTPiecesPerLimb <= NTTMaxShortPieces)
+	{
+		// quasi-linear, handles uneven operands by itself
+		multiplyNTT(*lh_obj, *rh_obj);
+	}
+	else if(rh_size >= (squaring ? BigInteger::ToomCook3SquareThreshold : BigInteger::ToomCook3Threshold))
+	{
+		// also covers products too long for a single transform, toom-3 and
+		// the slicing bring the partial products back under NTTMaxLength
+		// toom-3 splits both operands in thirds of the longer one, so it
+		// needs them within a factor of two
+		if(lh_size < 2*rh_size)
+			toomCook3(*lh_obj, *rh_obj);
+		else
+			multiplyUnbalanced(*lh_obj, *rh_obj);
+	}
+	else if(rh_size >= (squaring ? BigInteger::KaratsubaSquareThreshold : BigInteger::KaratsubaThreshold))
+	{
+		// using karatsuba algorithm
+		karatsuba(*lh_obj, *rh_obj);
+	}
+	else
+	{
+		// the product is written aside, *this may alias either operand
+		BigInteger::Storage result(lh_size + rh_size);
+		if(squaring)
+			squareLimbs(result.data(), lh_obj->storage.data(), lh_size);
+		else
+			multiplyLimbs(result.data(), lh_obj->storage.data(), lh_size, rh_obj->storage.data(), rh_size);
+		storage.swap(result);
+	}
+
+	sign = resultSign;
+	removeTrailingZeros();
+
+	#ifdef DEBUG_MULTIPLY
+	std::cout << "=====" << std::endl;
+	#endif
+}
+
+void BigInteger::divide(const BigInteger& lhs, const BigInteger& rhs)
+{
+	#ifdef DEBUG_DIVIDE
+	std::cout << "=====" << std::endl;
+	std::cout << "divide() called" << std::endl;
+	#endif
+
+	if (rhs.isZero())
+		throw "BigInteger::divide -> divide by zero";
+
+	// case for (0/B) or (A/B while A<B, 0 since the output is a integer)
+	if(lhs.isZero() || compareMagnitude(lhs, rhs)==BigInteger::LESS)
+	{
+		#ifdef DEBUG_DIVIDE
+		std::cout << "direct output 0, due to (0/b) or (a/b while a<b)" << std::endl;
+		#endif
+
+		operator = (0);
+		return;
+	}
+
+	// truncate toward zero, the sign follows the usual rule
+	Sign resultSign = static_cast<Sign>(lhs.sign * rhs.sign);
+	BigInteger remainder;
+	divideMagnitude(lhs, rhs, remainder);
+	sign = resultSign;
+
+	#ifdef DEBUG_DIVIDE
+	std::cout << "result: " << *this << std::endl;
+	std::cout << "=====" << std::endl;
+	#endif
+}
+
+void BigInteger::modulus(const BigInteger& lhs, const BigInteger& rhs)
+{
+	#ifdef DEBUG_MODULUS
+	std::cout << "=====" << std::endl;
+	std::cout << "modulus() called" << std::endl;
+	#endif
+
+	// the remainder falls out of the same division, the quotient is dropped
+	BigInteger quotient;
+	divmod(lhs, rhs, quotient, *this);
+
+	#ifdef DEBUG_MODULUS
+	std::cout << "result: " << *this << std::endl;
+	std::cout << "=====" << std::endl;
+	#endif
+}
+
+void BigInteger::divideMagnitude(const BigInteger& lhs, const BigInteger& rhs, BigInteger& remainder)
+{
+	// |lhs| >= |rhs| > 0 is guaranteed by the caller, the recursive methods
+	// only pay off when both the divisor and the quotient are long
+	std::size_t rh_size = rhs.storage.size(), quotient_size = lhs.storage.size() - rh_size + 1;
+	std::size_t shorter = (rh_size < quotient_size) ? rh_size : quotient_size;
+
+	if(shorter >= BigInteger::NewtonDivisionThreshold)
+		divideNewton(lhs, rhs, remainder);
+	else if(shorter >= BigInteger::BurnikelZieglerThreshold)
+		divideBurnikelZiegler(lhs, rhs, remainder);
+	else
+		divideKnuth(lhs, rhs, remainder);
+}
+
+void BigInteger::divideKnuth(const BigInteger& lhs, const BigInteger& rhs, BigInteger& remainder)
+{
+	std::size_t lh_size = lhs.storage.size(), rh_size = rhs.storage.size();
+
+	if(compareMagnitude(lhs, rhs) == BigInteger::LESS)
+	{
+		remainder = lhs;
+		if(!remainder.isZero())
+			remainder.sign = POSITIVE;
+		operator = (0);
+		return;
+	}
+
+	// both results are written aside, *this may alias either operand
+	BigInteger::Storage quotient(lh_size - rh_size + 1), rest(rh_size);
+	if(rh_size == 1)
+		rest[0] = divideSmall(quotient.data(), lhs.storage.data(), lh_size, rhs.storage[0]);
+	else
+		divideLimbs(quotient.data(), rest.data(), lhs.storage.data(), lh_size, rhs.storage.data(), rh_size);
+
+	remainder.storage.swap(rest);
+	remainder.sign = POSITIVE;
+	remainder.removeTrailingZeros();
+
+	storage.swap(quotient);
+	sign = POSITIVE;
+	removeTrailingZeros();
+}
+
+void BigInteger::divideBurnikelZiegler(const BigInteger& lhs, const BigInteger& rhs, BigInteger& remainder)
+{
+	// pad the divisor to n = m*2^k limbs with m under the threshold, so the
+	// recursion halves evenly all the way down to knuth's division
+	std::size_t rh_size = rhs.storage.size(), n = rh_size, levels = 0;
+	for(; n > BigInteger::BurnikelZieglerThreshold; levels++)
+		n = (n+1)/2;
+	n <<= levels;
+	std::size_t pad = n - rh_size;
+
+	// normalize, so that the top limb of the divisor is at least Base/2
+	BaseType factor = static_cast<BaseType>(BigInteger::Base / (static_cast<DoubleBaseType>(rhs.storage.back()) + 1));
+	BigInteger a(lhs), b(rhs);
+	a.sign = b.sign = POSITIVE;
+	a.multiplyBySmall(factor);
+	a.shiftLimbsLeft(pad);
+	b.multiplyBySmall(factor);
+	b.shiftLimbsLeft(pad);
+
+	// schoolbook division with n limb digits, each step is a 2n by n division
+	std::size_t blocks = (a.storage.size() + n - 1)/n;
+	BigInteger::Storage quotient(blocks*n, 0);
+	BigInteger rest, block, digit;
+	for(std::size_t index = blocks; index-- > 0;)
+	{
+		block.assignLimbs(a, index*n, n);
+		rest.shiftLimbsLeft(n);
+		rest += block;
+
+		digit.divide2n1n(rest, b, n, rest);
+		std::copy(digit.storage.begin(), digit.storage.end(), quotient.begin() + index*n);
+	}
+
+	// undo the normalization on what is left
+	rest.shiftLimbsRight(pad);
+	rest.divideBySmall(factor);
+	remainder = std::move(rest);
+
+	storage.swap(quotient);
+	sign = POSITIVE;
+	removeTrailingZeros();
+}
+
+void BigInteger::divide2n1n(const BigInteger& lhs, const BigInteger& rhs, std::size_t size, BigInteger& remainder)
+{
+	// requires lhs < rhs*Base^size with rhs normalized and size limbs long,
+	// lhs and remainder may be the same object
+	if(size % 2 == 1 || size <= BigInteger::BurnikelZieglerThreshold)
+	{
+		divideKnuth(lhs, rhs, remainder);
+		return;
+	}
+
+	std::size_t half = size/2;
+	BigInteger upper, lower, high, low, rest, quotient;
+	high.assignLimbs(rhs, half, half);
+	low.assignLimbs(rhs, 0, half);
+
+	// the top three halves first, then the remainder with the last half
+	upper.assignLimbs(lhs, half, 3*half);
+	lower.assignLimbs(lhs, 0, half);
+	quotient.divide3n2n(upper, rhs, high, low, half, rest);
+
+	rest.shiftLimbsLeft(half);
+	rest += lower;
+	operator = (std::move(quotient));
+	shiftLimbsLeft(half);
+	quotient.divide3n2n(rest, rhs, high, low, half, remainder);
+	operator += (quotient);
+}
+
+void BigInteger::divide3n2n(const BigInteger& lhs, const BigInteger& rhs, const BigInteger& high, const BigInteger& low, std::size_t half, BigInteger& remainder)
+{
+	// requires lhs < rhs*Base^half, rhs = high*Base^half + low
+	BigInteger top, upper, lower, estimate, rest;
+	top.assignLimbs(lhs, 2*half, half);
+	upper.assignLimbs(lhs, half, 2*half);
+	lower.assignLimbs(lhs, 0, half);
+
+	// estimate the quotient from the top two thirds and the top half of rhs
+	if(compareMagnitude(top, high) == BigInteger::LESS)
+		estimate.divide2n1n(upper, high, half, rest);
+	else
+	{
+		// the estimate saturates at Base^half-1
+		estimate.storage.assign(half, static_cast<BaseType>(BigInteger::Base-1));
+		estimate.sign = POSITIVE;
+		rest = upper + high;
+		upper = high;
+		upper.shiftLimbsLeft(half);
+		rest -= upper;
+	}
+
+	// the estimate is too large by at most two
+	rest.shiftLimbsLeft(half);
+	rest += lower;
+	rest -= estimate * low;
+	while(rest.sign == NEGATIVE)
+	{
+		rest += rhs;
+		--estimate;
+	}
+
+	operator = (std::move(estimate));
+	remainder = std::move(rest);
+}
+
+void BigInteger::divideNewton(const BigInteger& lhs, const BigInteger& rhs, BigInteger& remainder)
+{
+	// normalize, so that the reciprocal is between Base^k and 2*Base^k
+	BaseType factor = static_cast<BaseType>(BigInteger::Base / (static_cast<DoubleBaseType>(rhs.storage.back()) + 1));
+	BigInteger a(lhs), b(rhs);
+	a.sign = b.sign = POSITIVE;
+	a.multiplyBySmall(factor);
+	b.multiplyBySmall(factor);
+
+	std::size_t size = b.storage.size();
+	BigInteger inverse;
+	inverse.reciprocal(b);
+
+	// schoolbook division with size limb digits, every digit is estimated
+	// from the top size+1 limbs and the reciprocal
+	std::size_t blocks = (a.storage.size() + size - 1)/size;
+	BigInteger::Storage quotient(blocks*size, 0);
+	BigInteger rest, block, digit;
+	for(std::size_t index = blocks; index-- > 0;)
+	{
+		block.assignLimbs(a, index*size, size);
+		rest.shiftLimbsLeft(size);
+		rest += block;
+
+		digit.assignLimbs(rest, size-1, size+1);
+		digit *= inverse;
+		digit.shiftLimbsRight(size+1);
+
+		// the estimate is off by a few units at most
+		rest -= digit * b;
+		while(rest.sign == NEGATIVE)
+		{
+			rest += b;
+			--digit;
+		}
+		while(compareMagnitude(rest, b) != BigInteger::LESS)
+		{
+			rest -= b;
+			++digit;
+		}
+
+		std::copy(digit.storage.begin(), digit.storage.end(), quotient.begin() + index*size);
+	}
+
+	// undo the normalization on what is left
+	rest.divideBySmall(factor);
+	remainder = std::move(rest);
+
+	storage.swap(quotient);
+	sign = POSITIVE;
+	removeTrailingZeros();
+}
+
+void BigInteger::reciprocal(const BigInteger& rhs)
+{
+	// *this ~ Base^(2k) / rhs for a normalized rhs of k limbs, off by a few
+	// units at most
+	std::size_t size = rhs.storage.size();
+
+	if(size < BigInteger::NewtonDivisionThreshold)
+	{
+		BigInteger power(1), rest;
+		power.shiftLimbsLeft(2*size);
+		divideMagnitude(power, rhs, rest);
+		return;
+	}
+
+	// start from the reciprocal y of the top h limbs, a little over half of
+	// them so that one newton step reaches full precision
+	std::size_t half = (size+1)/2 + 2;
+	BigInteger top, estimate, error;
+	top.assignLimbs(rhs, size-half, half);
+	estimate.reciprocal(top);
+
+	// with x = y*Base^(k-h), the step x += x*(Base^(2k) - rhs*x) / Base^(2k)
+	// comes down to y*Base^(k-h) + y*(Base^(k+h) - rhs*y) / Base^(2h)
+	error = 1;
+	error.shiftLimbsLeft(size+half);
+	error -= rhs * estimate;
+	error *= estimate;
+	error.shiftLimbsRight(2*half);
+
+	operator = (std::move(estimate));
+	shiftLimbsLeft(size-half);
+	operator += (error);
+}
+
+void BigInteger::karatsuba(const BigInteger& lhs, const BigInteger& rhs)
+{
+	// only the magnitude is produced here, multiply() sets the sign
+	const BigInteger *lh_obj = &lhs, *rh_obj = &rhs;
+	if(lh_obj->storage.size() < rh_obj->storage.size())
+	{
+		lh_obj = &rhs;
+		rh_obj = &lhs;
+	}
+
+	std::size_t lh_size = lh_obj->storage.size(), rh_size = rh_obj->storage.size();
+	std::size_t half = (lh_size+1)/2;
+	if(parallelFor(rh_size) && rh_size > half)
+	{
+		// one level on BigIntegers, so that the three half size products
+		// can run on their own, they recurse through multiply()
+		const bool squaring = (&lhs == &rhs);
+		BigInteger x0, x1, y0, y1, xs, ys, z0, z1, z2;
+		x0.assignLimbs(*lh_obj, 0, half);
+		x1.assignLimbs(*lh_obj, half, lh_size-half);
+		xs = x0 + x1;
+		if(!squaring)
+		{
+			y0.assignLimbs(*rh_obj, 0, half);
+			y1.assignLimbs(*rh_obj, half, rh_size-half);
+			ys = y0 + y1;
+		}
+
+		std::function<void()> products[3];
+		products[0] = [&]() { z0.multiply(x0, squaring ? x0 : y0); };
+		products[1] = [&]() { z1.multiply(xs, squaring ? xs : ys); };
+		products[2] = [&]() { z2.multiply(x1, squaring ? x1 : y1); };
+		runTasks(products, 3, true);
+
+		// z1 - z0 - z2 is the middle term, non-negative
+		z1 -= z0;
+		z1 -= z2;
+		BigInteger::Storage result(lh_size + rh_size, 0);
+		addLimbsAt(result.data(), result.size(), 0, z0.storage.data(), z0.storage.size());
+		addLimbsAt(result.data(), result.size(), half, z1.storage.data(), z1.storage.size());
+		addLimbsAt(result.data(), result.size(), 2*half, z2.storage.data(), z2.storage.size());
+
+		storage.swap(result);
+		removeTrailingZeros();
+		return;
+	}
+
+	BigInteger::Storage result(lh_size + rh_size), scratch(karatsubaScratchSize(lh_size));
+	if(&lhs == &rhs)
+		karatsubaSquareLimbs(result.data(), lh_obj->storage.data(), lh_size, scratch.data());
+	else
+		karatsubaLimbs(result.data(), lh_obj->storage.data(), lh_size, rh_obj->storage.data(), rh_size, scratch.data());
+
+	storage.swap(result);
+	removeTrailingZeros();
+}
+
+void BigInteger::toomCook3(const BigInteger& lhs, const BigInteger& rhs)
+{
+	// only the magnitude is produced here, multiply() sets the sign
+	std::size_t lh_size = lhs.storage.size(), rh_size = rhs.storage.size();
+	std::size_t third = ((lh_size > rh_size ? lh_size : rh_size) + 2)/3;
+
+	// a square only needs the evaluations of lhs, and its pointwise products
+	// are squares again
+	const bool squaring = (&lhs == &rhs);
+
+	// split both operands as x2*X^2 + x1*X + x0 with X = Base^third
+	BigInteger a0, a1, a2, b0, b1, b2;
+	a0.assignLimbs(lhs, 0, third);
+	a1.assignLimbs(lhs, third, third);
+	a2.assignLimbs(lhs, 2*third, third);
+	if(!squaring)
+	{
+		b0.assignLimbs(rhs, 0, third);
+		b1.assignLimbs(rhs, third, third);
+		b2.assignLimbs(rhs, 2*third, third);
+	}
+
+	// evaluate at 0, 1, -1, -2 and infinity
+	BigInteger p1(a0 + a2), pm1, pm2, q1, qm1, qm2;
+	pm1 = p1 - a1;
+	p1 += a1;
+	pm2 = pm1 + a2;
+	pm2 *= 2;
+	pm2 -= a0;
+	if(!squaring)
+	{
+		q1 = b0 + b2;
+		qm1 = q1 - b1;
+		q1 += b1;
+		qm2 = qm1 + b2;
+		qm2 *= 2;
+		qm2 -= b0;
+	}
+
+	// pointwise products, these recurse through multiply() and are
+	// independent of each other
+	BigInteger r0, r1, rm1, rm2, rinf;
+	std::function<void()> products[5];
+	products[0] = [&]() { r0.multiply(a0, squaring ? a0 : b0); };
+	products[1] = [&]() { r1.multiply(p1, squaring ? p1 : q1); };
+	products[2] = [&]() { rm1.multiply(pm1, squaring ? pm1 : qm1); };
+	products[3] = [&]() { rm2.multiply(pm2, squaring ? pm2 : qm2); };
+	products[4] = [&]() { rinf.multiply(a2, squaring ? a2 : b2); };
+	runTasks(products, 5, parallelFor(rh_size));
+
+	// interpolate, the divisions are exact
+	BigInteger r2, r3;
+	r3 = rm2 - r1;
+	r3.divideBySmall(3);
+	r1 -= rm1;
+	r1.divideBySmall(2);
+	r2 = rm1 - r0;
+	r3 = r2 - r3;
+	r3.divideBySmall(2);
+	r3 += rinf;
+	r3 += rinf;
+	r2 += r1;
+	r2 -= rinf;
+	r1 -= r3;
+
+	// recompose, every coefficient is non-negative now
+	const BigInteger* coefficients[5] = { &r0, &r1, &r2, &r3, &rinf };
+	BigInteger::Storage result(lh_size + rh_size, 0);
+	for(std::size_t index = 0; index < 5; index++)
+		addLimbsAt(result.data(), result.size(), index*third, coefficients[index]->storage.data(), coefficients[index]->storage.size());
+
+	storage.swap(result);
+	sign = POSITIVE;
+	removeTrailingZeros();
+}
+
+void BigInteger::multiplyUnbalanced(const BigInteger& lhs, const BigInteger& rhs)
+{
+	// only the magnitude is produced here, multiply() sets the sign
+	std::size_t lh_size = lhs.storage.size(), rh_size = rhs.storage.size();
+
+	// slice the longer lhs into pieces as long as rhs, so that every partial
+	// product is balanced
+	BigInteger::Storage result(lh_size + rh_size, 0);
+	if(parallelFor(rh_size))
+	{
+		// every slice is multiplied on its own, the sums stay serial
+		std::size_t count = (lh_size + rh_size-1)/rh_size;
+		std::vector<BigInteger> products(count);
+		std::vector<std::function<void()> > tasks(count);
+		for(std::size_t slice = 0; slice < count; slice++)
+		{
+			tasks[slice] = [&lhs, &rhs, &products, slice, rh_size]()
+			{
+				BigInteger piece;
+				piece.assignLimbs(lhs, slice*rh_size, rh_size);
+				products[slice].multiply(piece, rhs);
+			};
+		}
+		runTasks(tasks.data(), count, true);
+
+		for(std::size_t slice = 0; slice < count; slice++)
+			addLimbsAt(result.data(), result.size(), slice*rh_size, products[slice].storage.data(), products[slice].storage.size());
+	}
+	else
+	{
+		BigInteger piece, product;
+		for(std::size_t offset = 0; offset < lh_size; offset += rh_size)
+		{
+			piece.assignLimbs(lhs, offset, rh_size);
+			product.multiply(piece, rhs);
+			addLimbsAt(result.data(), result.size(), offset, product.storage.data(), product.storage.size());
+		}
+	}
+
+	storage.swap(result);
+	sign = POSITIVE;
+	removeTrailingZeros();
+}
+
+void BigInteger::addMagnitude(const BigInteger& lhs, const BigInteger& rhs)
+{
+	const BigInteger *lh_obj = &lhs, *rh_obj = &rhs;
+	if(lh_obj->storage.size() < rh_obj->storage.size())
+	{
+		lh_obj = &rhs;
+		rh_obj = &lhs;
+	}
+
+	// the kernel runs in place, so grow the storage first and fetch the
+	// pointers afterwards, *this may alias either operand
+	std::size_t lh_size = lh_obj->storage.size(), rh_size = rh_obj->storage.size();
+	storage.resize(lh_size);
+	BaseType carry = addLimbs(storage.data(), lh_obj->storage.data(), lh_size, rh_obj->storage.data(), rh_size);
+	if(carry != 0)
+		storage.push_back(carry);
+}
+
+void BigInteger::subtractMagnitude(const BigInteger& lhs, const BigInteger& rhs)
+{
+	// |lhs| >= |rhs| is guaranteed by the caller, *this may alias either
+	// operand, growing it only pads the subtrahend with zeros
+	std::size_t lh_size = lhs.storage.size(), rh_size = rhs.storage.size();
+	storage.resize(lh_size);
+	subtractLimbs(storage.data(), lhs.storage.data(), lh_size, rhs.storage.data(), rh_size);
+
+	removeTrailingZeros();
+}
+
+void BigInteger::incrementMagnitude()
+{
+	BaseType one = 1, carry = 1;
+
+	// an empty storage is 0, the carry becomes the only limb
+	if(!storage.empty())
+		carry = addLimbs(storage.data(), storage.data(), storage.size(), &one, 1);
+
+	if(carry != 0)
+		storage.push_back(carry);
+}
+
+void BigInteger::decrementMagnitude()
+{
+	// the magnitude is at least one here
+	BaseType one = 1;
+	subtractLimbs(storage.data(), storage.data(), storage.size(), &one, 1);
+	removeTrailingZeros();
+}
+
+void BigInteger::multiplyNTT(const BigInteger& lhs, const BigInteger& rhs)
+{
+	// only the magnitude is produced here, multiply() sets the sign
+	std::size_t lh_size = lhs.storage.size(), rh_size = rhs.storage.size();
+	std::size_t pieces = (lh_size+rh_size)*NTTPiecesPerLimb, size = 1;
+	while(size < pieces)
+		size <<= 1;
+
+	// a square transforms its only operand once
+	std::vector<unsigned int> lh_pieces, rh_pieces, residue1, residue2, residue3;
+	splitPieces(lh_pieces, lhs.storage.data(), lh_size);
+	if(&lhs != &rhs)
+		splitPieces(rh_pieces, rhs.storage.data(), rh_size);
+	const std::vector<unsigned int>& rh_source = (&lhs == &rhs) ? lh_pieces : rh_pieces;
+
+	// the three primes are independent of each other
+	const bool parallel = parallelFor(rh_size);
+	std::function<void()> convolutions[3];
+	convolutions[0] = [&]() { nttConvolve<NTTPrime1, 3>(residue1, lh_pieces, rh_source, size, parallel); };
+	convolutions[1] = [&]() { nttConvolve<NTTPrime2, 3>(residue2, lh_pieces, rh_source, size, parallel); };
+	convolutions[2] = [&]() { nttConvolve<NTTPrime3, 11>(residue3, lh_pieces, rh_source, size, parallel); };
+	runTasks(convolutions, 3, parallel);
+
+	// garner's recombination, a coefficient needs up to 86 bits
+	const unsigned long long prime12 = static_cast<unsigned long long>(NTTPrime1) * NTTPrime2;
+	const unsigned long long inverse1 = powerMod(NTTPrime1, NTTPrime2-2, NTTPrime2);
+	const unsigned long long inverse12 = powerMod(prime12 % NTTPrime3, NTTPrime3-2, NTTPrime3);
+
+	BigInteger::Storage result(lh_size + rh_size, 0);
+	unsigned long long carry = 0, high, low, digit;
+	BaseType scale = 1;
+	for(std::size_t index = 0; index < pieces; index++)
+	{
+		unsigned long long r1 = residue1[index], r2 = residue2[index], r3 = residue3[index];
+		digit = (r2 + NTTPrime2 - r1) * inverse1 % NTTPrime2;
+		unsigned long long value12 = r1 + NTTPrime1 * digit;
+		digit = (r3 + NTTPrime3 - value12 % NTTPrime3) * inverse12 % NTTPrime3;
+
+		// high:low = value12 + prime12*digit + carry
+		multiplyWide(prime12, digit, high, low);
+		low += value12;
+		high += (low < value12) ? 1 : 0;
+		low += carry;
+		high += (low < carry) ? 1 : 0;
+
+		// normalize the carry in piece sized steps
+		digit = low % NTTPieceBase;
+#if !defined(BIGINTEGER_LIMB_BITS)
+		// decimal coefficients never leave the low word
+		carry = low / NTTPieceBase;
+#else
+		carry = (high << 32) | (low >> 32);
+#endif
+
+		if(index % NTTPiecesPerLimb == 0)
+			scale = 1;
+		result[index/NTTPiecesPerLimb] += static_cast<BaseType>(digit) * scale;
+		scale = static_cast<BaseType>(scale * NTTPieceBase);
+	}
+
+	storage.swap(result);
+	removeTrailingZeros();
+}
+
+void BigInteger::multiplyBySmall(BaseType rhs)
+{
+	// multiply the magnitude in place and keep the sign
+	BaseType carry = multiplySmall(storage.data(), storage.data(), storage.size(), rhs);
+	if(carry != 0)
+		storage.push_back(carry);
+	if(rhs == 0)
+		operator = (0);
+}
+
+BigInteger::BaseType BigInteger::divideBySmall(BaseType rhs)
+{
+	// divide the magnitude in place and keep the sign
+	BaseType remainder = divideSmall(storage.data(), storage.data(), storage.size(), rhs);
+	removeTrailingZeros();
+	return remainder;
+}
+
+void BigInteger::parse(const char* input, std::size_t length)
+{
+	const char *first = input, *last = input + length;
+
+	// parse the sign from string
+	Sign resultSign = POSITIVE;
+	if(first != last && *first == '-')
+	{
+		resultSign = NEGATIVE;
+		++first;
+	}
+
+	// check the digits up front, null characters are skipped
+	std::size_t nulls = 0;
+	for(const char* iterator = first; iterator != last; ++iterator)
+	{
+		if(*iterator == '\0')
+			nulls++;
+		else if(!std::isdigit(static_cast<unsigned char>(*iterator)))
+			throw "BigInteger::BigInteger(const std::string&) -> not a digit";
+	}
+
+	if(nulls == 0)
+		parseMagnitude(first, last - first);
+	else
+	{
+		std::string digits;
+		digits.reserve(last - first - nulls);
+		for(const char* iterator = first; iterator != last; ++iterator)
+		{
+			if(*iterator != '\0')
+				digits.push_back(*iterator);
+		}
+		parseMagnitude(digits.data(), digits.size());
+	}
+
+	if(!isZero())
+		sign = resultSign;
+}
+
+void BigInteger::parseMagnitude(const char* digits, std::size_t length)
+{
+	storage.clear();
+	sign = POSITIVE;
+
+#if !defined(BIGINTEGER_LIMB_BITS)
+	// groups map onto the limbs, filled from the least significant digit
+	storage.reserve((length + BaseMagnitude10 - 1)/BaseMagnitude10);
+	for(std::size_t end = length; end > 0;)
+	{
+		std::size_t begin = (end > BaseMagnitude10) ? end - BaseMagnitude10 : 0;
+		BaseType newgroup = 0;
+		for(std::size_t index = begin; index < end; index++)
+			newgroup = newgroup*10 + static_cast<BaseType>(digits[index]-'0');
+
+		storage.push_back(newgroup);
+		end = begin;
+	}
+#else
+	// binary limbs can't be split on digit boundaries, split the text in
+	// halves instead and join them with cached powers of IOBase
+	std::size_t groups = (length + IOBaseMagnitude10 - 1)/IOBaseMagnitude10, levels = 0;
+	while((static_cast<std::size_t>(1) << levels) < groups)
+		levels++;
+
+	std::vector<const BigInteger*> powers(levels);
+	for(std::size_t level = 0; level < levels; level++)
+		powers[level] = &powerOfIOBase(level);
+
+	parseDigits(digits, length, powers.data());
+#endif
+
+	removeTrailingZeros();
+}
+
+void BigInteger::parseDigits(const char* digits, std::size_t length, const BigInteger* const* powers)
+{
+	std::size_t groups = (length + IOBaseMagnitude10 - 1)/IOBaseMagnitude10;
+	if(groups > ParseBasecaseGroups)
+	{
+		// the low half is the largest power of two count of groups below
+		// the total, so the same cached powers serve every call
+		std::size_t level = 0;
+		while((static_cast<std::size_t>(2) << level) < groups)
+			level++;
+
+		std::size_t low_digits = (static_cast<std::size_t>(1) << level) * IOBaseMagnitude10;
+		BigInteger low;
+		parseDigits(digits, length - low_digits, powers);
+		low.parseDigits(digits + length - low_digits, low_digits, powers);
+		multiply(*this, *powers[level]);
+		add(*this, low);
+		return;
+	}
+
+	// fold IOBase sized groups in from the most significant digit
+	storage.clear();
+	sign = POSITIVE;
+
+	BaseType newgroup = 0, magnifier = 1, carry;
+	for(std::size_t index = 0; index < length; index++)
+	{
+		newgroup = newgroup*10 + static_cast<BaseType>(digits[index]-'0');
+		magnifier *= 10;
+
+		// shift the storage by a full group and add the new one in
+		if(magnifier == IOBase)
+		{
+			carry = multiplySmall(storage.data(), storage.data(), storage.size(), magnifier, newgroup);
+			if(carry != 0)
+				storage.push_back(carry);
+			newgroup = 0;
+			magnifier = 1;
+		}
+	}
+
+	// fold the remaining partial group
+	if(magnifier > 1)
+	{
+		carry = multiplySmall(storage.data(), storage.data(), storage.size(), magnifier, newgroup);
+		if(carry != 0)
+			storage.push_back(carry);
+	}
+
+	removeTrailingZeros();
+}
+
+const BigInteger& BigInteger::powerOfIOBase(std::size_t level)
+{
+	// IOBase^(2^level), each one the square of the previous, kept for the
+	// lifetime of the program and shared between threads
+	static std::mutex lock;
+	static std::deque<BigInteger> powers;
+
+	std::lock_guard<std::mutex> guard(lock);
+
+	// the cache must not take blocks from a caller's arena
+	LimbAllocatorScope scope(HeapLimbAllocator::instance());
+	if(powers.empty())
+	{
+		BigInteger base;
+#if !defined(BIGINTEGER_LIMB_BITS)
+		// IOBase is the limb base itself
+		base.storage.push_back(0);
+		base.storage.push_back(1);
+#else
+		base.storage.push_back(static_cast<BaseType>(IOBase));
+#endif
+		base.sign = POSITIVE;
+		powers.push_back(base);
+	}
+
+	while(powers.size() <= level)
+		powers.push_back(powers.back() * powers.back());
+
+	return powers[level];
+}
+
+void BigInteger::assignLimbs(const BigInteger& source, std::size_t offset, std::size_t count)
+{
+	// take limbs [offset, offset+count) of source as a positive value
+	std::size_t size = source.storage.size();
+	std::size_t first = (offset < size) ? offset : size;
+	std::size_t last = (count < size-first) ? first+count : size;
+
+	storage.assign(source.storage.begin()+first, source.storage.begin()+last);
+	sign = POSITIVE;
+	removeTrailingZeros();
+}
+
+void BigInteger::shiftLimbsLeft(std::size_t count)
+{
+	// multiply by Base^count
+	if(!isZero())
+		storage.insert(storage.begin(), count, 0);
+}
+
+void BigInteger::shiftLimbsRight(std::size_t count)
+{
+	// divide the magnitude by Base^count, truncating toward zero
+	if(count >= storage.size())
+		operator = (0);
+	else
+		storage.erase(storage.begin(), storage.begin() + count);
+}
+
+void BigInteger::toDecimalGroups(std::vector<BaseType>& groups) const
+{
+	groups.clear();
+
+#if !defined(BIGINTEGER_LIMB_BITS)
+	groups.assign(storage.begin(), storage.end());
+#else
+	// peel off IOBase sized groups from the least significant end
+	Storage buffer(storage);
+	while(!buffer.empty())
+	{
+		groups.push_back(divideSmall(buffer.data(), buffer.data(), buffer.size(), IOBase));
+		while(!buffer.empty() && buffer.back() == 0)
+			buffer.pop_back();
+	}
+#endif
+}
+
+void BigInteger::toDecimalDigits(std::vector<char>& digits) const
+{
+	// the largest cached power with twice its length not above ours splits
+	// the value in halves, the value is below its square
+	std::size_t level = 0;
+	std::vector<const BigInteger*> powers;
+	do
+		powers.push_back(&powerOfIOBase(level++));
+	while(2*powers.back()->storage.size() - 1 <= storage.size());
+
+	BigInteger magnitude(*this);
+	magnitude.sign = POSITIVE;
+	digits.resize((static_cast<std::size_t>(1) << level) * IOBaseMagnitude10);
+	writeDigits(magnitude, level, powers.data(), digits.data());
+}
+
+void BigInteger::writeDigits(const BigInteger& value, std::size_t level, const BigInteger* const* powers, char* digits)
+{
+	// writes exactly 2^level groups, value < IOBase^(2^level)
+	std::size_t width = (static_cast<std::size_t>(1) << level) * IOBaseMagnitude10;
+	if(level == 0 || value.storage.size() <= ConvertBasecaseLimbs)
+	{
+		// peel groups off the low end, the rest is zero padding
+		Storage buffer(value.storage);
+		char* position = digits + width;
+		while(!buffer.empty())
+		{
+			BaseType group = divideSmall(buffer.data(), buffer.data(), buffer.size(), IOBase);
+			while(!buffer.empty() && buffer.back() == 0)
+				buffer.pop_back();
+
+			for(std::size_t digit = 0; digit < IOBaseMagnitude10; digit++, group /= 10)
+				*--position = static_cast<char>('0' + group%10);
+		}
+		std::fill(digits, position, '0');
+		return;
+	}
+
+	BigInteger quotient, remainder;
+	divmod(value, *powers[level-1], quotient, remainder);
+	writeDigits(quotient, level-1, powers, digits);
+	writeDigits(remainder, level-1, powers, digits + width/2);
+}
+
+BigInteger::Compare BigInteger::compare(const BigInteger& lhs, const BigInteger& rhs) const
+{
+	// compate sign first
+	if(lhs.sign > rhs.sign)
+		return BigInteger::GREATER;
+	else if(lhs.sign < rhs.sign)
+		return BigInteger::LESS;
+
+	// compare by magnitude and ajust by the sign
+	if(lhs.sign == BigInteger::POSITIVE)
+		return compareMagnitude(lhs, rhs);
+	else
+		return compareMagnitude(rhs, lhs);
+}
+
+int BigInteger::getPreciseMagnitude() const
+{
+	if(isZero())
+		return 0;
+
+#if !defined(BIGINTEGER_LIMB_BITS)
+	int result = static_cast<int>(storage.size()-1) * BigInteger::BaseMagnitude10;
+
+	// find out the digit counts for the msg(most significant group)
+	for(BaseType top = storage.back(); top > 0; result++, top /= 10);
+
+	return result;
+#else
+	// 2^(bits-1) <= |value| < 2^bits, so the value has the digits of
+	// 2^(bits-1) or one more, the latter only when a power of ten lies in
+	// that range
+	std::size_t bits = (storage.size()-1) * BIGINTEGER_LIMB_BITS;
+	for(BaseType top = storage.back(); top > 0; bits++, top >>= 1);
+
+	int digits = static_cast<int>(std::floor((bits-1) * 0.30102999566398119521)) + 1;
+	if(digits * 3.32192809488736234787 > bits + 1e-6)
+		return digits;
+	return (compareMagnitude(*this, pow(BigInteger(10), digits)) == BigInteger::LESS) ? digits : digits+1;
+#endif
+}
+
+BigInteger::Compare BigInteger::compareMagnitude(const BigInteger& lhs, const BigInteger& rhs) const
+{
+	switch(compareLimbs(lhs.storage.data(), lhs.storage.size(), rhs.storage.data(), rhs.storage.size()))
+	{
+		case 1:
+			return BigInteger::GREATER;
+		case -1:
+			return BigInteger::LESS;
+		default:
+			return BigInteger::EQUAL;
+	}
+}
+
+bool BigInteger::isZero() const
+{
+	return sign==BigInteger::ZERO;
+}
+
+void BigInteger::removeTrailingZeros()
+{
+	while(!storage.empty() && storage.back() == 0)
+		storage.pop_back();
+
+	// set sign flag to zero if the storage is empty
+	if(storage.empty())
+		sign = BigInteger::ZERO;
+
+	// leave the capacity alone unless the allocator wants it back
+	storage.trim();
+}
+
+//
+// modular arithmetic
+//
+// Montgomery form keeps a residue x as x*R mod m with R = Base^n for an n
+// limb modulus, so that a product is reduced by adding multiples of m
+// until the low n limbs are zero, without any division. That needs m
+// coprime to Base, odd for binary limbs and coprime to 10 for decimal ones.
+// Other moduli, and ModContext, use barrett reduction instead.
+//
+
+// -value^-1 modulo Base, value must be coprime to Base
+static BaseType negatedInverseLimb(BaseType value)
+{
+#if !defined(BIGINTEGER_LIMB_BITS)
+	// extended euclid, the base is small
+	long long r0 = BigInteger::Base, r1 = value, t0 = 0, t1 = 1, quotient, temp;
+	while(r1 != 0)
+	{
+		quotient = r0 / r1;
+		temp = r0 - quotient*r1; r0 = r1; r1 = temp;
+		temp = t0 - quotient*t1; t0 = t1; t1 = temp;
+	}
+	long long base = static_cast<long long>(BigInteger::Base);
+	return static_cast<BaseType>((base - (t0 % base + base) % base) % base);
+#else
+	// newton iteration, value*value = 1 modulo 8 already holds for odd
+	// values and every step doubles the correct low bits
+	BaseType inverse = value;
+	for(int step = 0; step < 5; step++)
+		inverse *= static_cast<BaseType>(2 - value*inverse);
+	return static_cast<BaseType>(0 - inverse);
+#endif
+}
+
+#if defined(BIGINTEGER_LIMB_BITS) && BIGINTEGER_LIMB_BITS == 64
+// result += lhs * rhs over size limbs, returns the carry out of the top limb
+static BaseType multiplyAddLimbs(BaseType* result, const BaseType* lhs, std::size_t size, BaseType rhs)
+{
+	DoubleBaseType buffer;
+	BaseType carry = 0;
+
+	for(std::size_t index = 0; index < size; index++)
+	{
+		buffer = static_cast<DoubleBaseType>(lhs[index]) * rhs + result[index] + carry;
+		carry = static_cast<BaseType>(buffer / BigInteger::Base);
+		result[index] = static_cast<BaseType>(buffer % BigInteger::Base);
+	}
+
+	return carry;
+}
+#endif
+
+// all ones when value is zero and all zeros otherwise, without a branch
+static BaseType zeroMask(std::size_t value)
+{
+	return static_cast<BaseType>(((value | (0 - value)) >> (sizeof(std::size_t)*8 - 1)) - 1);
+}
+
+// result = lhs - rhs over size limbs without a branch, the borrow is the
+// sign bit of the wide difference and Base goes back in under a mask;
+// returns the borrow out of the top limb
+static BaseType subtractLimbsMasked(BaseType* result, const BaseType* lhs, const BaseType* rhs, std::size_t size)
+{
+	const unsigned int top = sizeof(DoubleBaseType)*8 - 1;
+	DoubleBaseType difference, borrow = 0;
+
+	for(std::size_t index = 0; index < size; index++)
+	{
+		difference = static_cast<DoubleBaseType>(lhs[index]) - rhs[index] - borrow;
+		borrow = difference >> top;
+		result[index] = static_cast<BaseType>(difference + (static_cast<DoubleBaseType>(BigInteger::Base) & (0 - borrow)));
+	}
+
+	return static_cast<BaseType>(borrow);
+}
+
+class Montgomery
+{
+public:
+	explicit Montgomery(const BaseType* modulus, std::size_t size) : modulus(modulus, modulus+size), size(size),
+		inverse(negatedInverseLimb(modulus[0])), wide(2*size+1), scratch(karatsubaScratchSize(size))
+	{
+	}
+
+	// result = lhs * rhs / R mod m, result may alias either operand; the
+	// secure form skips the recursive products, whose branches depend on
+	// the values, and does the final subtraction without a branch
+	void multiply(BaseType* result, const BaseType* lhs, const BaseType* rhs, bool secure)
+	{
+		if(secure || size < BigInteger::KaratsubaThreshold)
+			multiplyLimbs(wide.data(), lhs, size, rhs, size);
+		else
+			karatsubaLimbs(wide.data(), lhs, size, rhs, size, scratch.data());
+		reduce(result, secure);
+	}
+
+	void square(BaseType* result, const BaseType* operand, bool secure)
+	{
+		if(secure || size < BigInteger::KaratsubaSquareThreshold)
+			squareLimbs(wide.data(), operand, size);
+		else
+			karatsubaSquareLimbs(wide.data(), operand, size, scratch.data());
+		reduce(result, secure);
+	}
+
+	// result = value / R mod m for a value of at most 2n limbs below m*R
+	void reduce(BaseType* result, const BaseType* value, std::size_t count, bool secure)
+	{
+		for(std::size_t index = 0; index < 2*size; index++)
+			wide[index] = (index < count) ? value[index] : 0;
+		reduce(result, secure);
+	}
+
+private:
+	std::vector<BaseType> modulus;
+	std::size_t size;
+	BaseType inverse;
+	std::vector<BaseType> wide;
+	BigInteger::Storage scratch;
+
+#if !defined(BIGINTEGER_LIMB_BITS) || BIGINTEGER_LIMB_BITS == 32
+	std::vector<DoubleBaseType> low, high;
+#endif
+
+	// result = wide / R mod m, one multiple of m per limb clears the low
+	// half, then the value is below 2m
+	void reduce(BaseType* result, bool secure)
+	{
+		BaseType factor, overflow;
+#if !defined(BIGINTEGER_LIMB_BITS) || BIGINTEGER_LIMB_BITS == 32
+		// the multiples go through the row kernel into column accumulators
+		// as in multiplyLimbsDeferred(), only the column whose factor is
+		// needed next gets its carry
+		const LimbKernels& kernels = limbKernels();
+		DoubleBaseType carry = 0, column;
+		low.assign(wide.begin(), wide.begin()+2*size);
+		high.assign(2*size+1, 0);
+
+		for(std::size_t index = 0; index < size; index++)
+		{
+			column = low[index] + high[index] + carry;
+			factor = static_cast<BaseType>(column % BigInteger::Base * inverse % BigInteger::Base);
+			kernels.multiplyRow(low.data()+index, high.data()+index+1, modulus.data(), size, factor);
+			carry = (low[index] + high[index] + carry) / BigInteger::Base;
+		}
+		for(std::size_t index = size; index < 2*size; index++)
+		{
+			column = low[index] + high[index] + carry;
+			wide[index] = static_cast<BaseType>(column % BigInteger::Base);
+			carry = column / BigInteger::Base;
+		}
+		overflow = static_cast<BaseType>(carry);
+#else
+		// the top carry rides along one limb higher every round
+		DoubleBaseType buffer;
+		overflow = 0;
+		for(std::size_t index = 0; index < size; index++)
+		{
+			factor = wide[index] * inverse;
+			buffer = static_cast<DoubleBaseType>(wide[index+size]) + multiplyAddLimbs(wide.data()+index, modulus.data(), size, factor) + overflow;
+			wide[index+size] = static_cast<BaseType>(buffer);
+			overflow = static_cast<BaseType>(buffer >> 64);
+		}
+#endif
+
+		// take m off once if the value is not below m
+		BaseType* upper = wide.data()+size;
+		if(secure)
+		{
+			BaseType borrow = subtractLimbsMasked(result, upper, modulus.data(), size);
+
+			// keep the difference unless it borrowed without an overflow
+			BaseType keep = zeroMask(borrow & ~overflow & 1);
+			for(std::size_t index = 0; index < size; index++)
+				result[index] = (result[index] & keep) | (upper[index] & ~keep);
+		}
+		else if(subtractLimbsFrom(result, upper, size, modulus.data(), size, 0, 0) != 0 && overflow == 0)
+			std::memcpy(result, upper, size*sizeof(BaseType));
+	}
+};
+
+ModContext::ModContext(const BigInteger& modulus) : m(modulus)
+{
+	if(m.isZero())
+		throw "ModContext::ModContext -> modulus is zero";
+
+	m.sign = BigInteger::POSITIVE;
+	size = m.storage.size();
+
+	// floor(Base^2n / m), n+1 limbs
+	BigInteger top(1);
+	top.shiftLimbsLeft(2*size);
+	reciprocal = top / m;
+}
+
+const BigInteger& ModContext::modulus() const
+{
+	return m;
+}
+
+BigInteger ModContext::reduce(const BigInteger& value) const
+{
+	BigInteger result(value);
+	reduceInPlace(result);
+	return result;
+}
+
+BigInteger ModContext::mulmod(const BigInteger& lhs, const BigInteger& rhs) const
+{
+	// a square when both are the same object
+	BigInteger result;
+	result.multiply(lhs, rhs);
+	reduceInPlace(result);
+	return result;
+}
+
+BigInteger ModContext::addmod(const BigInteger& lhs, const BigInteger& rhs) const
+{
+	BigInteger result(lhs + rhs);
+	reduceInPlace(result);
+	return result;
+}
+
+BigInteger ModContext::submod(const BigInteger& lhs, const BigInteger& rhs) const
+{
+	BigInteger result(lhs - rhs);
+	reduceInPlace(result);
+	return result;
+}
+
+void ModContext::reduceInPlace(BigInteger& value) const
+{
+	BigInteger::Sign valueSign = value.sign;
+	value.sign = value.isZero() ? BigInteger::ZERO : BigInteger::POSITIVE;
+
+	// operands already reduced, as from addmod() and submod() on residues,
+	// are off by at most one modulus
+	std::size_t length = value.storage.size();
+	if(size == 1)
+	{
+		// a single limb modulus divides directly
+		BigInteger::BaseType remainder = value.divideBySmall(m.storage[0]);
+		value.storage.assign(1, remainder);
+		value.sign = BigInteger::POSITIVE;
+		value.removeTrailingZeros();
+	}
+	else if(length <= size)
+	{
+		if(value.compareMagnitude(value, m) != BigInteger::LESS)
+			value -= m;
+		if(value.compareMagnitude(value, m) != BigInteger::LESS)
+			barrettStep(value);
+	}
+	else if(length <= 2*size)
+		barrettStep(value);
+	else
+	{
+		// fold n limbs at a time in from the top, r*Base^n + chunk stays
+		// below m*Base^n <= Base^2n for r < m
+		BigInteger chunk;
+		std::size_t offset = ((length-1)/size)*size;
+		BigInteger result;
+		result.assignLimbs(value, offset, length-offset);
+		barrettStep(result);
+		while(offset > 0)
+		{
+			offset -= size;
+			chunk.assignLimbs(value, offset, size);
+			result.shiftLimbsLeft(size);
+			result += chunk;
+			barrettStep(result);
+		}
+		value = std::move(result);
+	}
+
+	if(valueSign == BigInteger::NEGATIVE && !value.isZero())
+		value = m - value;
+}
+
+void ModContext::barrettStep(BigInteger& value) const
+{
+	// 0 <= value < Base^2n, the estimate floor(floor(value / Base^(n-1)) *
+	// reciprocal / Base^(n+1)) is at most two below the quotient
+	if(value.compareMagnitude(value, m) == BigInteger::LESS)
+		return;
+
+	BigInteger estimate;
+	estimate.assignLimbs(value, size-1, size+1);
+	estimate *= reciprocal;
+	estimate.shiftLimbsRight(size+1);
+	value -= estimate * m;
+	while(value.compareMagnitude(value, m) != BigInteger::LESS)
+		value -= m;
+}
+
+// the bits of a magnitude, least significant first
+static void magnitudeBits(std::vector<unsigned char>& bits, const BaseType* limbs, std::size_t size)
+{
+	bits.clear();
+#if !defined(BIGINTEGER_LIMB_BITS)
+	// peel off 13 bits at a time, 2^13 is the largest power of two below
+	// Base, over the full length every time so that only the length counts;
+	// the division by 2^13 is a shift and a mask, the exponent never meets
+	// a hardware divide
+	const unsigned int chunk = 13;
+	const BaseType mask = (1u << chunk) - 1;
+	std::vector<BaseType> buffer(limbs, limbs+size);
+	std::size_t rounds = (size*14 + chunk-1)/chunk;
+	for(std::size_t round = 0; round < rounds; round++)
+	{
+		BaseType piece = 0;
+		for(std::size_t index = size; index-- > 0;)
+		{
+			BaseType value = piece * BigInteger::Base + buffer[index];
+			buffer[index] = value >> chunk;
+			piece = value & mask;
+		}
+		for(unsigned int bit = 0; bit < chunk; bit++)
+			bits.push_back(static_cast<unsigned char>((piece >> bit) & 1));
+	}
+#else
+	for(std::size_t index = 0; index < size; index++)
+	{
+		for(unsigned int bit = 0; bit < BIGINTEGER_LIMB_BITS; bit++)
+			bits.push_back(static_cast<unsigned char>((limbs[index] >> bit) & 1));
+	}
+#endif
+}
+
+// sliding window width for an exponent of the given bit length
+static unsigned int windowBits(std::size_t length)
+{
+	if(length > 671)
+		return 6;
+	if(length > 239)
+		return 5;
+	if(length > 79)
+		return 4;
+	if(length > 23)
+		return 3;
+	return (length > 6) ? 2 : 1;
+}
+
+// the radix whose powers are shifts, and its digits per limb
+#if !defined(BIGINTEGER_LIMB_BITS)
+static const BaseType ShiftRadix = 10;
+static const unsigned int ShiftRadixDigits = BigInteger::BaseMagnitude10;
+#else
+static const BaseType ShiftRadix = 2;
+static const unsigned int ShiftRadixDigits = BIGINTEGER_LIMB_BITS;
+#endif
+
+BigInteger BigInteger::pow(const BigInteger& base, unsigned long long exponent)
+{
+	if(exponent == 0)
+		return BigInteger(1);
+	if(base.isZero())
+		return BigInteger();
+
+	// base = rest * radix^shift with the radix 10 for decimal limbs and 2
+	// for binary ones, so that the power of the radix is a shift
+	std::size_t zeroLimbs = 0;
+	while(base.storage[zeroLimbs] == 0)
+		zeroLimbs++;
+	BaseType low = base.storage[zeroLimbs], factor = 1;
+	unsigned int digits = 0;
+	while(low % ShiftRadix == 0)
+	{
+		low /= ShiftRadix;
+		factor *= ShiftRadix;
+		digits++;
+	}
+
+	BigInteger rest, result;
+	rest.assignLimbs(base, zeroLimbs, base.storage.size()-zeroLimbs);
+	if(factor > 1)
+		rest.divideBySmall(factor);
+
+	std::size_t length = 0;
+	while(length < 64 && (exponent >> length) != 0)
+		length++;
+
+	if(rest.storage.size() == 1)
+	{
+		// a single limb multiplier costs a linear pass, plain left to right
+		// square and multiply is as good as any window
+		BaseType multiplier = rest.storage[0];
+		result = rest;
+		for(std::size_t index = length-1; index-- > 0 && multiplier != 1;)
+		{
+			result.multiply(result, result);
+			if((exponent >> index) & 1)
+				result.multiplyBySmall(multiplier);
+		}
+	}
+	else
+	{
+		// sliding windows over the odd powers rest^1, rest^3, ...
+		const unsigned int width = windowBits(length);
+		std::vector<BigInteger> table(static_cast<std::size_t>(1) << (width-1));
+		BigInteger squared;
+		table[0] = rest;
+		squared.multiply(rest, rest);
+		for(std::size_t entry = 1; entry < table.size(); entry++)
+			table[entry].multiply(table[entry-1], squared);
+
+		bool started = false;
+		std::size_t index = length;
+		while(index-- > 0)
+		{
+			if(((exponent >> index) & 1) == 0)
+			{
+				result.multiply(result, result);
+				continue;
+			}
+
+			// the longest window of at most width bits that ends in a one
+			std::size_t lowest = (index+1 >= width) ? index+1-width : 0;
+			while(((exponent >> lowest) & 1) == 0)
+				lowest++;
+			std::size_t value = static_cast<std::size_t>((exponent >> lowest) & ((1ULL << (index-lowest+1)) - 1));
+			if(started)
+			{
+				for(std::size_t step = lowest; step <= index; step++)
+					result.multiply(result, result);
+				result.multiply(result, table[value/2]);
+			}
+			else
+				result = table[value/2];
+			started = true;
+			index = lowest;
+		}
+	}
+
+	// radix^(shift*exponent) = Base^limbs * radix^digits
+	unsigned long long shift = (static_cast<unsigned long long>(zeroLimbs)*ShiftRadixDigits + digits) * exponent;
+	BaseType scale = 1;
+	for(unsigned long long digit = 0; digit < shift % ShiftRadixDigits; digit++)
+		scale *= ShiftRadix;
+	if(scale > 1)
+		result.multiplyBySmall(scale);
+	result.shiftLimbsLeft(static_cast<std::size_t>(shift / ShiftRadixDigits));
+
+	result.sign = (base.sign == NEGATIVE && exponent % 2 == 1) ? NEGATIVE : POSITIVE;
+	return result;
+}
+
+BigInteger BigInteger::powmod(const BigInteger& base, const BigInteger& exponent, const BigInteger& modulus)
+{
+	return powerModulo(base, exponent, modulus, false);
+}
+
+BigInteger BigInteger::powmodSecure(const BigInteger& base, const BigInteger& exponent, const BigInteger& modulus)
+{
+	return powerModulo(base, exponent, modulus, true);
+}
+
+BigInteger BigInteger::powerModulo(const BigInteger& base, const BigInteger& exponent, const BigInteger& modulus, bool secure)
+{
+	if(modulus.isZero())
+		throw "BigInteger::powmod -> modulus is zero";
+	if(exponent.sign == NEGATIVE)
+		throw "BigInteger::powmod -> negative exponent";
+
+	BigInteger m(modulus);
+	m.sign = POSITIVE;
+	std::size_t size = m.storage.size();
+
+	// the residue of the base in [0, m)
+	BigInteger residue(base % m);
+	if(residue.sign == NEGATIVE)
+		residue += m;
+
+	bool montgomery;
+#if !defined(BIGINTEGER_LIMB_BITS)
+	montgomery = (m.storage[0] % 2 != 0 && m.storage[0] % 5 != 0);
+#else
+	montgomery = (m.storage[0] % 2 != 0);
+#endif
+	if(secure && !montgomery)
+		throw "BigInteger::powmodSecure -> modulus not coprime to the limb base";
+
+	if(size == 1 && m.storage[0] == 1)
+		return BigInteger();
+
+	std::vector<unsigned char> bits;
+	magnitudeBits(bits, exponent.storage.data(), exponent.storage.size());
+	std::size_t length = bits.size();
+	if(!secure)
+	{
+		while(length > 0 && bits[length-1] == 0)
+			length--;
+	}
+	if(length == 0)
+		return BigInteger(1);
+
+	if(!montgomery)
+	{
+		// left to right square and multiply, with barrett reduction
+		ModContext context(m);
+		BigInteger result(residue);
+		for(std::size_t index = length-1; index-- > 0;)
+		{
+			result = context.mulmod(result, result);
+			if(bits[index])
+				result = context.mulmod(result, residue);
+		}
+		return result;
+	}
+
+	// into montgomery form, one = R mod m and the base as base*R mod m
+	Montgomery context(m.storage.data(), size);
+	BigInteger one(1), scaled(residue);
+	one.shiftLimbsLeft(size);
+	one %= m;
+	scaled.shiftLimbsLeft(size);
+	scaled %= m;
+	one.storage.resize(size, 0);
+	scaled.storage.resize(size, 0);
+
+	std::vector<BaseType> result(one.storage.begin(), one.storage.end());
+	std::vector<BaseType> table;
+
+	if(secure)
+	{
+		// fixed windows, every window squares w times and multiplies by a
+		// table entry that is picked by reading the whole table
+		const unsigned int width = 4;
+		const std::size_t entries = static_cast<std::size_t>(1) << width;
+		table.resize(entries*size);
+		std::copy(one.storage.begin(), one.storage.end(), table.begin());
+		std::copy(scaled.storage.begin(), scaled.storage.end(), table.begin()+size);
+		for(std::size_t entry = 2; entry < entries; entry++)
+			context.multiply(&table[entry*size], &table[(entry-1)*size], &table[size], true);
+
+		std::vector<BaseType> selected(size);
+		std::size_t windows = (length + width-1)/width;
+		for(std::size_t window = windows; window-- > 0;)
+		{
+			std::size_t value = 0;
+			for(unsigned int bit = width; bit-- > 0;)
+			{
+				std::size_t position = window*width + bit;
+				value = (value << 1) | ((position < length) ? bits[position] : 0);
+				context.square(result.data(), result.data(), true);
+			}
+
+			for(std::size_t index = 0; index < size; index++)
+				selected[index] = 0;
+			for(std::size_t entry = 0; entry < entries; entry++)
+			{
+				BaseType mask = zeroMask(entry ^ value);
+				for(std::size_t index = 0; index < size; index++)
+					selected[index] |= table[entry*size+index] & mask;
+			}
+			context.multiply(result.data(), result.data(), selected.data(), true);
+		}
+	}
+	else
+	{
+		// sliding windows over the odd powers base^1, base^3, ...
+		const unsigned int width = windowBits(length);
+		const std::size_t entries = static_cast<std::size_t>(1) << (width-1);
+		std::vector<BaseType> squared(size);
+		table.resize(entries*size);
+		std::copy(scaled.storage.begin(), scaled.storage.end(), table.begin());
+		context.square(squared.data(), &table[0], false);
+		for(std::size_t entry = 1; entry < entries; entry++)
+			context.multiply(&table[entry*size], &table[(entry-1)*size], squared.data(), false);
+
+		bool started = false;
+		std::size_t index = length;
+		while(index-- > 0)
+		{
+			if(bits[index] == 0)
+			{
+				context.square(result.data(), result.data(), false);
+				continue;
+			}
+
+			// the longest window of at most width bits that ends in a one
+			std::size_t low = (index+1 >= width) ? index+1-width : 0;
+			while(bits[low] == 0)
+				low++;
+			std::size_t value = 0;
+			for(std::size_t position = index+1; position-- > low;)
+			{
+				value = (value << 1) | bits[position];
+				if(started)
+					context.square(result.data(), result.data(), false);
+			}
+
+			if(started)
+				context.multiply(result.data(), result.data(), &table[(value/2)*size], false);
+			else
+				std::copy(table.begin() + (value/2)*size, table.begin() + (value/2+1)*size, result.begin());
+			started = true;
+			index = low;
+		}
+	}
+
+	// out of montgomery form
+	BigInteger answer;
+	answer.storage.resize(size);
+	context.reduce(answer.storage.data(), result.data(), size, secure);
+	answer.sign = POSITIVE;
+	answer.removeTrailingZeros();
+	return answer;
+}
+
+//
+// greatest common divisor
+//
+// Lehmer's algorithm runs euclid on the leading 62 bits of both operands
+// and only touches the full values once per word of quotients, through a
+// 2x2 cofactor matrix. Large operands go through the half gcd instead,
+// which reduces the top half recursively and applies the matrices with
+// the fast multiplications. Every matrix is a product of euclid steps, so
+// it has determinant +-1 and keeps the gcd of the values it is applied to
+// whatever their low limbs hold; a matrix from the leading limbs only
+// makes less progress when it overshoots, it can't give a wrong result.
+//
+
+// limbs of the largest values the word sized binary gcd handles
+#if !defined(BIGINTEGER_LIMB_BITS)
+static const std::size_t WordLimbs = 4;
+#else
+static const std::size_t WordLimbs = 64 / BIGINTEGER_LIMB_BITS;
+#endif
+
+// cofactors of a lehmer matrix stay below this, so that the limb kernel
+// below can take them as multipliers in every limb mode
+static const long long LehmerCofactorLimit = 0xffffffffLL;
+
+// the value of at most WordLimbs limbs
+static unsigned long long limbsToWord(const BaseType* limbs, std::size_t size)
+{
+	unsigned long long value = 0;
+	for(std::size_t index = size; index-- > 0;)
+	{
+#if !defined(BIGINTEGER_LIMB_BITS)
+		value = value*BigInteger::Base + limbs[index];
+#elif BIGINTEGER_LIMB_BITS == 32
+		value = (value << 32) | limbs[index];
+#else
+		value = limbs[index];
+#endif
+	}
+	return value;
+}
+
+#if defined(BIGINTEGER_LIMB_BITS)
+// 64 bits of a magnitude from bit position shift on
+static unsigned long long limbBits(const BaseType* limbs, std::size_t size, std::size_t shift)
+{
+	std::size_t index = shift / BIGINTEGER_LIMB_BITS, offset = shift % BIGINTEGER_LIMB_BITS;
+#if BIGINTEGER_LIMB_BITS == 32
+	unsigned long long low = limbsToWord(limbs + index, (size-index < 2) ? size-index : 2);
+	unsigned long long high = (index+2 < size) ? limbs[index+2] : 0;
+#else
+	unsigned long long low = limbs[index];
+	unsigned long long high = (index+1 < size) ? limbs[index+1] : 0;
+#endif
+	return (offset == 0) ? low : (low >> offset) | (high << (64-offset));
+}
+#endif
+
+// floor(lhs / R) and floor(rhs / R) for the power R of the limb radix that
+// leaves the first below 2^62, lehmer's leading words; requires lhs >= rhs
+static void leadingWords(const BaseType* lhs, std::size_t lh_size, const BaseType* rhs, std::size_t rh_size, unsigned long long& x, unsigned long long& y)
+{
+#if !defined(BIGINTEGER_LIMB_BITS)
+	x = 0;
+	y = 0;
+	for(std::size_t index = lh_size; index-- > 0 && x < (1ULL << 62) / BigInteger::Base;)
+	{
+		x = x*BigInteger::Base + lhs[index];
+		y = y*BigInteger::Base + ((index < rh_size) ? rhs[index] : 0);
+	}
+#else
+	std::size_t length = (lh_size-1)*BIGINTEGER_LIMB_BITS;
+	for(BaseType top = lhs[lh_size-1]; top != 0; top >>= 1)
+		length++;
+
+	std::size_t shift = (length > 62) ? length-62 : 0;
+	x = limbBits(lhs, lh_size, shift);
+	y = (rh_size*BIGINTEGER_LIMB_BITS > shift) ? limbBits(rhs, rh_size, shift) : 0;
+#endif
+}
+
+// lehmer's inner loop (knuth's algorithm L) on leading words x >= y. A
+// quotient is only taken when it is the same for both bounds on the true
+// ratio, so the matrix (A B; C D) in matrix is exact for the full values
+// a and b: a' = A*a + B*b and b' = C*a + D*b. Returns false when not even
+// the first quotient is certain.
+static bool lehmerMatrix(unsigned long long x, unsigned long long y, long long* matrix)
+{
+	long long u = static_cast<long long>(x), v = static_cast<long long>(y);
+	long long a = 1, b = 0, c = 0, d = 1, temp;
+	while(v + c > 0 && v + d > 0)
+	{
+		long long quotient = (u + a) / (v + c);
+		if(quotient == 0 || quotient != (u + b) / (v + d))
+			break;
+
+		// the signs alternate, so |a - quotient*c| = |a| + quotient*|c|
+		long long ma = (a < 0) ? -a : a, mb = (b < 0) ? -b : b;
+		long long mc = (c < 0) ? -c : c, md = (d < 0) ? -d : d;
+		if((mc != 0 && quotient > (LehmerCofactorLimit - ma) / mc) || (md != 0 && quotient > (LehmerCofactorLimit - mb) / md))
+			break;
+
+		temp = a - quotient*c; a = c; c = temp;
+		temp = b - quotient*d; b = d; d = temp;
+		temp = u - quotient*v; u = v; v = temp;
+	}
+
+	matrix[0] = a;
+	matrix[1] = b;
+	matrix[2] = c;
+	matrix[3] = d;
+	return b != 0;
+}
+
+// result = lhs*x - rhs*y over size limbs for multipliers below 2^32, the
+// operands zero extended to size; the difference must be non-negative and
+// fit in size limbs, result may alias either operand
+static void combineLimbs(BaseType* result, const BaseType* lhs, std::size_t lh_size, unsigned long long x, const BaseType* rhs, std::size_t rh_size, unsigned long long y, std::size_t size)
+{
+	DoubleBaseType lhs_carry = 0, rhs_carry = 0;
+	BaseType borrow = 0;
+	for(std::size_t index = 0; index < size; index++)
+	{
+		DoubleBaseType left = static_cast<DoubleBaseType>((index < lh_size) ? lhs[index] : 0) * x + lhs_carry;
+		DoubleBaseType right = static_cast<DoubleBaseType>((index < rh_size) ? rhs[index] : 0) * y + rhs_carry;
+		lhs_carry = left / BigInteger::Base;
+		rhs_carry = right / BigInteger::Base;
+
+		DoubleBaseType minuend = left % BigInteger::Base, subtrahend = right % BigInteger::Base + borrow;
+		if(minuend >= subtrahend)
+		{
+			result[index] = static_cast<BaseType>(minuend - subtrahend);
+			borrow = 0;
+		}
+		else
+		{
+			result[index] = static_cast<BaseType>(minuend + BigInteger::Base - subtrahend);
+			borrow = 1;
+		}
+	}
+}
+
+// gcd of two words, one of them may be zero
+static unsigned long long binaryGcd(unsigned long long lhs, unsigned long long rhs)
+{
+	if(lhs == 0 || rhs == 0)
+		return lhs | rhs;
+
+	unsigned int shift = 0;
+	while(((lhs | rhs) & 1) == 0)
+	{
+		lhs >>= 1;
+		rhs >>= 1;
+		shift++;
+	}
+	while((lhs & 1) == 0)
+		lhs >>= 1;
+
+	// lhs stays odd, rhs loses its factors of two and the smaller one
+	while(rhs != 0)
+	{
+		while((rhs & 1) == 0)
+			rhs >>= 1;
+		if(lhs > rhs)
+			std::swap(lhs, rhs);
+		rhs -= lhs;
+	}
+	return lhs << shift;
+}
+
+BigInteger BigInteger::gcd(const BigInteger& lhs, const BigInteger& rhs)
+{
+	BigInteger a(lhs), b(rhs);
+	if(a.sign == NEGATIVE)
+		a.sign = POSITIVE;
+	if(b.sign == NEGATIVE)
+		b.sign = POSITIVE;
+	if(a.compareMagnitude(a, b) == LESS)
+		std::swap(a, b);
+
+	if(!b.isZero())
+		gcdReduce(a, b, 0);
+	return a;
+}
+
+BigInteger BigInteger::lcm(const BigInteger& lhs, const BigInteger& rhs)
+{
+	if(lhs.isZero() || rhs.isZero())
+		return BigInteger();
+
+	BigInteger result(lhs / gcd(lhs, rhs));
+	result *= rhs;
+	if(result.sign == NEGATIVE)
+		result.sign = POSITIVE;
+	return result;
+}
+
+BigInteger BigInteger::gcdext(const BigInteger& lhs, const BigInteger& rhs, BigInteger& x, BigInteger& y)
+{
+	BigInteger a(lhs), b(rhs);
+	if(a.sign == NEGATIVE)
+		a.sign = POSITIVE;
+	if(b.sign == NEGATIVE)
+		b.sign = POSITIVE;
+
+	// the larger magnitude goes first, its cofactor is followed through the
+	// reduction and the other one comes from an exact division at the end
+	bool swapped = (a.compareMagnitude(a, b) == LESS);
+	if(swapped)
+		std::swap(a, b);
+	BigInteger larger(a), smaller(b), first, second;
+
+	if(b.isZero())
+	{
+		first = BigInteger(a.isZero() ? 0 : 1);
+	}
+	else
+	{
+		BigInteger cofactor[2] = {1, 0};
+		gcdReduce(a, b, cofactor);
+
+		// the cofactor of least magnitude, |first| <= smaller/(2g)
+		BigInteger period(smaller / a);
+		first = cofactor[0] % period;
+		if(first.sign == NEGATIVE)
+			first += period;
+		BigInteger twice(first + first);
+		if(twice.compareMagnitude(twice, period) == GREATER)
+			first -= period;
+		second = (a - larger*first) / smaller;
+	}
+
+	if(swapped)
+		std::swap(first, second);
+	if(lhs.sign == NEGATIVE && !first.isZero())
+		first.sign = static_cast<Sign>(-first.sign);
+	if(rhs.sign == NEGATIVE && !second.isZero())
+		second.sign = static_cast<Sign>(-second.sign);
+
+	// a and b went in by value, so x and y may alias lhs and rhs
+	x = std::move(first);
+	y = std::move(second);
+	return a;
+}
+
+BigInteger BigInteger::invmod(const BigInteger& value, const BigInteger& modulus)
+{
+	if(modulus.isZero())
+		throw "BigInteger::invmod -> modulus is zero";
+
+	BigInteger m(modulus);
+	m.sign = POSITIVE;
+	BigInteger residue(value % m);
+	if(residue.sign == NEGATIVE)
+		residue += m;
+
+	BigInteger inverse, unused;
+	BigInteger g(gcdext(residue, m, inverse, unused));
+	if(g.storage.size() != 1 || g.storage[0] != 1)
+		throw "BigInteger::invmod -> value not invertible";
+
+	if(inverse.sign == NEGATIVE)
+		inverse += m;
+	return inverse;
+}
+
+BigInteger BigInteger::fromWord(unsigned long long value)
+{
+	BigInteger result;
+	while(value != 0)
+	{
+#if defined(BIGINTEGER_LIMB_BITS) && BIGINTEGER_LIMB_BITS == 64
+		result.storage.push_back(value);
+		value = 0;
+#else
+		result.storage.push_back(static_cast<BaseType>(value % BigInteger::Base));
+		value /= BigInteger::Base;
+#endif
+	}
+	if(!result.storage.empty())
+		result.sign = POSITIVE;
+	return result;
+}
+
+void BigInteger::gcdReduce(BigInteger& a, BigInteger& b, BigInteger* cofactor)
+{
+	// the cofactors, when asked for, are one column following a and b
+	std::size_t columns = (cofactor != 0) ? 1 : 0;
+	while(!b.isZero())
+	{
+		if(columns == 0 && a.storage.size() <= WordLimbs)
+		{
+			a = fromWord(binaryGcd(limbsToWord(a.storage.data(), a.storage.size()), limbsToWord(b.storage.data(), b.storage.size())));
+			b = 0;
+			return;
+		}
+
+		if(b.storage.size() >= HalfGcdThreshold && halfGcd(a, b, cofactor, columns))
+			continue;
+		euclidStep(a, b, cofactor, columns);
+	}
+}
+
+bool BigInteger::halfGcd(BigInteger& a, BigInteger& b, BigInteger* rows, std::size_t columns)
+{
+	// reduce a and b, of size limbs, until b is down to about half of that;
+	// quotients found on the top part of a pair only hold for the whole
+	// pair while the top part keeps a good margin, so stop limbs are kept
+	std::size_t size = a.storage.size(), stop = size/2 + 2;
+	if(b.storage.size() <= stop)
+		return false;
+
+	if(size >= HalfGcdThreshold)
+	{
+		// the top half first, which takes a and b down to about 3/4 of size
+		std::size_t shift = size/2;
+		BigInteger top, bottom, matrix[4] = {1, 0, 0, 1};
+		top.assignLimbs(a, shift, size);
+		bottom.assignLimbs(b, shift, size);
+		if(halfGcd(top, bottom, matrix, 2))
+			applyMatrix(matrix, a, b, rows, columns);
+
+		// then the top of what is left, cut so that its half ends near stop
+		std::size_t length = a.storage.size();
+		if(b.storage.size() > stop && length < size && 2*(stop-2) > length)
+		{
+			shift = 2*(stop-2) - length;
+			matrix[0] = 1;
+			matrix[1] = 0;
+			matrix[2] = 0;
+			matrix[3] = 1;
+			top.assignLimbs(a, shift, length);
+			bottom.assignLimbs(b, shift, length);
+			if(halfGcd(top, bottom, matrix, 2))
+				applyMatrix(matrix, a, b, rows, columns);
+		}
+	}
+
+	while(!b.isZero() && b.storage.size() > stop)
+		euclidStep(a, b, rows, columns);
+	return true;
+}
+
+void BigInteger::euclidStep(BigInteger& a, BigInteger& b, BigInteger* rows, std::size_t columns)
+{
+	unsigned long long x, y;
+	long long matrix[4];
+	leadingWords(a.storage.data(), a.storage.size(), b.storage.data(), b.storage.size(), x, y);
+
+	if(!lehmerMatrix(x, y, matrix))
+	{
+		// a plain division step, the quotient didn't fit the leading words
+		BigInteger quotient, remainder;
+		divmod(a, b, quotient, remainder);
+		a = std::move(b);
+		b = std::move(remainder);
+		for(std::size_t column = 0; column < columns; column++)
+		{
+			BigInteger next(rows[column] - quotient*rows[columns+column]);
+			rows[column] = std::move(rows[columns+column]);
+			rows[columns+column] = std::move(next);
+		}
+		return;
+	}
+
+	// a' = A*a + B*b and b' = C*a + D*b, in each pair the coefficients have
+	// opposite signs and the result is a remainder, so non-negative
+	std::size_t size = a.storage.size();
+	BigInteger next[2];
+	for(int row = 0; row < 2; row++)
+	{
+		long long first = matrix[2*row], second = matrix[2*row+1];
+		next[row].storage.resize(size);
+		if(second <= 0)
+			combineLimbs(next[row].storage.data(), a.storage.data(), size, first, b.storage.data(), b.storage.size(), -second, size);
+		else
+			combineLimbs(next[row].storage.data(), b.storage.data(), b.storage.size(), second, a.storage.data(), size, -first, size);
+		next[row].sign = POSITIVE;
+		next[row].removeTrailingZeros();
+	}
+	a = std::move(next[0]);
+	b = std::move(next[1]);
+
+	if(columns == 0)
+		return;
+	BigInteger factor[4];
+	for(int entry = 0; entry < 4; entry++)
+	{
+		factor[entry] = fromWord((matrix[entry] < 0) ? -matrix[entry] : matrix[entry]);
+		if(matrix[entry] < 0)
+			factor[entry].sign = NEGATIVE;
+	}
+	for(std::size_t column = 0; column < columns; column++)
+	{
+		BigInteger first(factor[0]*rows[column] + factor[1]*rows[columns+column]);
+		BigInteger second(factor[2]*rows[column] + factor[3]*rows[columns+column]);
+		rows[column] = std::move(first);
+		rows[columns+column] = std::move(second);
+	}
+}
+
+void BigInteger::applyMatrix(const BigInteger* matrix, BigInteger& a, BigInteger& b, BigInteger* rows, std::size_t columns)
+{
+	BigInteger first(matrix[0]*a + matrix[1]*b), second(matrix[2]*a + matrix[3]*b);
+	a = std::move(first);
+	b = std::move(second);
+	for(std::size_t column = 0; column < columns; column++)
+	{
+		BigInteger top(matrix[0]*rows[column] + matrix[1]*rows[columns+column]);
+		BigInteger bottom(matrix[2]*rows[column] + matrix[3]*rows[columns+column]);
+		rows[column] = std::move(top);
+		rows[columns+column] = std::move(bottom);
+	}
+
+	// a matrix that overshot may leave a negative value or the pair out of
+	// order, flipping a row or swapping both keeps it unimodular
+	if(a.sign == NEGATIVE)
+	{
+		a.sign = POSITIVE;
+		for(std::size_t column = 0; column < columns; column++)
+			if(!rows[column].isZero())
+				rows[column].sign = static_cast<Sign>(-rows[column].sign);
+	}
+	if(b.sign == NEGATIVE)
+	{
+		b.sign = POSITIVE;
+		for(std::size_t column = 0; column < columns; column++)
+			if(!rows[columns+column].isZero())
+				rows[columns+column].sign = static_cast<Sign>(-rows[columns+column].sign);
+	}
+	if(a.compareMagnitude(a, b) == LESS)
+	{
+		std::swap(a, b);
+		for(std::size_t column = 0; column < columns; column++)
+			std::swap(rows[column], rows[columns+column]);
+	}
+}
+
+//
+// roots
+//
+// Newton's iteration x' = ((k-1)*x + n/x^(k-1)) / k on integers decreases
+// from any start above the root until it reaches floor(n^(1/k)). The
+// start comes from the root of the leading half of n, computed the same
+// way, so every level doubles the correct limbs and only takes a step or
+// two. The smallest roots start from a floating point estimate.
+//
+
+// value modulo a single limb divisor
+static BaseType remainderSmall(const BaseType* limbs, std::size_t size, BaseType divisor)
+{
+	DoubleBaseType buffer = 0;
+	for(std::size_t index = size; index-- > 0;)
+		buffer = (buffer * BigInteger::Base + limbs[index]) % divisor;
+	return static_cast<BaseType>(buffer);
+}
+
+BigInteger BigInteger::isqrt(const BigInteger& value)
+{
+	if(value.sign == NEGATIVE)
+		throw "BigInteger::isqrt -> negative value";
+	if(value.isZero())
+		return BigInteger();
+	return rootMagnitude(value, 2, 0);
+}
+
+BigInteger BigInteger::iroot(const BigInteger& value, unsigned int k)
+{
+	if(k == 0)
+		throw "BigInteger::iroot -> zeroth root";
+	if(value.sign == NEGATIVE && k % 2 == 0)
+		throw "BigInteger::iroot -> even root of a negative value";
+	if(value.isZero() || k == 1)
+		return value;
+
+	BigInteger magnitude(value);
+	magnitude.sign = POSITIVE;
+	BigInteger result(rootMagnitude(magnitude, k, 0));
+	result.sign = value.sign;
+	return result;
+}
+
+bool BigInteger::isPerfectSquare() const
+{
+	if(isZero())
+		return true;
+	if(sign == NEGATIVE)
+		return false;
+
+	// squares take 12 of the 64 residues modulo 64 (4 of 16 modulo 16 for
+	// decimal limbs, which is all the low limb tells), and about a quarter,
+	// half, half and 3/5 of those modulo 63, 11, 13 and 5; together that
+	// leaves one non-square in a hundred for the root
+#if !defined(BIGINTEGER_LIMB_BITS)
+	if(((0x213ULL >> (storage[0] % 16)) & 1) == 0)
+		return false;
+#else
+	if(((0x202021202030213ULL >> (storage[0] % 64)) & 1) == 0)
+		return false;
+#endif
+	BaseType residue = remainderSmall(storage.data(), storage.size(), 63*11*13*5);
+	if(((0x402483012450293ULL >> (residue % 63)) & 1) == 0 || ((0x23bULL >> (residue % 11)) & 1) == 0 || ((0x161bULL >> (residue % 13)) & 1) == 0 || ((0x13ULL >> (residue % 5)) & 1) == 0)
+		return false;
+
+	bool exact;
+	rootMagnitude(*this, 2, &exact);
+	return exact;
+}
+
+BigInteger BigInteger::rootEstimate(const BigInteger& value, unsigned int k)
+{
+	// value = leading * Base^(size-top) from the top limbs, the logarithm of
+	// the root is good to about 13 digits, the margin covers that
+	const double base = static_cast<double>(BigInteger::Base);
+	std::size_t size = value.storage.size(), top = (size < 3) ? size : 3;
+	double leading = 0;
+	for(std::size_t index = size; index-- > size-top;)
+		leading = leading*base + static_cast<double>(value.storage[index]);
+	double root = std::exp((std::log(leading) + static_cast<double>(size-top)*std::log(base)) / k);
+	root = root*(1 + 1e-9) + 1;
+
+	// only asked for roots below Base, anything from 2^63 up starts at Base
+	if(root >= 9.2e18)
+	{
+		BigInteger result(1);
+		result.shiftLimbsLeft(1);
+		return result;
+	}
+	return fromWord(static_cast<unsigned long long>(root));
+}
+
+BigInteger BigInteger::rootMagnitude(const BigInteger& value, unsigned int k, bool* exact)
+{
+	// at least the bits of value, then the root is 1 (decimal limbs have
+	// fewer than 14 bits each)
+	std::size_t size = value.storage.size();
+#if !defined(BIGINTEGER_LIMB_BITS)
+	unsigned long long bits = static_cast<unsigned long long>(size)*14;
+#else
+	unsigned long long bits = static_cast<unsigned long long>(size-1)*BIGINTEGER_LIMB_BITS;
+	for(BaseType top = value.storage[size-1]; top != 0; top >>= 1)
+		bits++;
+#endif
+	if(k >= bits)
+	{
+		if(exact != 0)
+			*exact = (size == 1 && value.storage[0] == 1);
+		return BigInteger(1);
+	}
+
+	// the root has at most limbs limbs, the root of value without its low
+	// k*half limbs gives the upper half of them
+	std::size_t limbs = (size + k-1) / k, half = limbs / 2;
+	BigInteger x;
+	if(half == 0)
+		x = rootEstimate(value, k);
+	else
+	{
+		BigInteger top;
+		top.assignLimbs(value, k*half, size);
+		x = rootMagnitude(top, k, 0);
+		x.incrementMagnitude();
+		x.shiftLimbsLeft(half);
+	}
+
+	// newton from above, a step that doesn't go down means x is the root,
+	// and so does x^k <= value as no step goes below the root
+	BigInteger power(pow(x, k-1)), order(fromWord(k)), next, check;
+	while(true)
+	{
+		next = x;
+		next.multiply(next, fromWord(k-1));
+		next += value / power;
+		next /= order;
+		if(next >= x)
+		{
+			if(exact != 0)
+				*exact = (power*x == value);
+			return x;
+		}
+
+		x = std::move(next);
+		power = pow(x, k-1);
+		check = (k == 2) ? x.square() : power*x;
+		if(check <= value)
+		{
+			if(exact != 0)
+				*exact = (check == value);
+			return x;
+		}
+	}
+}
+
+//
+// products
+//
+// Folding factors into an accumulator one at a time costs a pass over the
+// accumulator per factor, quadratic in the length of the result. A
+// balanced tree multiplies operands of about the same size at every level
+// instead, which is where karatsuba, toom and the NTT pay off. Small
+// factors are first packed into words, several to a leaf.
+//
+
+// appends factor to the packed words, a word takes factors for as long as
+// their product fits
+static void packFactor(std::vector<unsigned long long>& words, unsigned long long factor)
+{
+	if(!words.empty() && words.back() <= ~0ULL / factor)
+		words.back() *= factor;
+	else
+		words.push_back(factor);
+}
+
+// the primes up to n, by the sieve of eratosthenes
+static void sievePrimes(std::vector<unsigned long long>& primes, unsigned long long n)
+{
+	std::vector<bool> composite(static_cast<std::size_t>(n < 2 ? 2 : n+1), false);
+	for(unsigned long long number = 2; number <= n; number++)
+	{
+		if(composite[static_cast<std::size_t>(number)])
+			continue;
+		primes.push_back(number);
+		if(number <= n/number)
+		{
+			for(unsigned long long multiple = number*number; multiple <= n; multiple += number)
+				composite[static_cast<std::size_t>(multiple)] = true;
+		}
+	}
+}
+
+// largest n for which binomial() sieves the primes up to n, a bit each
+static const unsigned long long BinomialSieveLimit = 1ULL << 28;
+
+BigInteger BigInteger::product(const BigInteger* first, const BigInteger* last)
+{
+	if(first == last)
+		return BigInteger(1);
+	return productTree(first, static_cast<std::size_t>(last - first));
+}
+
+BigInteger BigInteger::factorial(unsigned long long n)
+{
+	std::vector<unsigned long long> words;
+	for(unsigned long long factor = 2; factor <= n; factor++)
+		packFactor(words, factor);
+	return productOfWords(words);
+}
+
+BigInteger BigInteger::binomial(unsigned long long n, unsigned long long k)
+{
+	if(k > n)
+		return BigInteger();
+	if(k > n-k)
+		k = n-k;
+
+	std::vector<unsigned long long> words;
+	if(k >= n/64 && n <= BinomialSieveLimit)
+	{
+		// the exponent of a prime p in n choose k is the number of carries
+		// when k and n-k are added in base p (kummer), so the result comes
+		// straight from prime powers; the sieve only pays with k a good part
+		// of n
+		std::vector<unsigned long long> primes;
+		sievePrimes(primes, n);
+		for(std::size_t index = 0; index < primes.size(); index++)
+		{
+			unsigned long long prime = primes[index], lhs = k, rhs = n-k, carry = 0;
+			while(lhs != 0 || rhs != 0)
+			{
+				carry = (lhs % prime + rhs % prime + carry >= prime) ? 1 : 0;
+				if(carry)
+					packFactor(words, prime);
+				lhs /= prime;
+				rhs /= prime;
+			}
+		}
+		return productOfWords(words);
+	}
+
+	// n!/(n-k)! over k!, both from product trees, the division is exact
+	for(unsigned long long factor = n-k+1; factor <= n && factor != 0; factor++)
+		packFactor(words, factor);
+	return productOfWords(words) / factorial(k);
+}
+
+BigInteger BigInteger::primorial(unsigned long long n)
+{
+	std::vector<unsigned long long> primes, words;
+	sievePrimes(primes, n);
+	for(std::size_t index = 0; index < primes.size(); index++)
+		packFactor(words, primes[index]);
+	return productOfWords(words);
+}
+
+BigInteger BigInteger::productOfWords(const std::vector<unsigned long long>& words)
+{
+	if(words.empty())
+		return BigInteger(1);
+
+	std::vector<BigInteger> leaves(words.size());
+	for(std::size_t index = 0; index < words.size(); index++)
+		leaves[index] = fromWord(words[index]);
+	return productTree(leaves.data(), leaves.size());
+}
+
+BigInteger BigInteger::productTree(const BigInteger* values, std::size_t count)
+{
+	if(count == 1)
+		return values[0];
+	if(count == 2)
+		return values[0] * values[1];
+
+	// split where half of the limbs are on either side, so that factors of
+	// mixed lengths still meet operands of their own size
+	std::size_t total = 0, half = 0, split = 0;
+	for(std::size_t index = 0; index < count; index++)
+		total += values[index].storage.size();
+	while(split < count-1 && (split == 0 || 2*(half + values[split].storage.size()) <= total))
+		half += values[split++].storage.size();
+
+	// the two halves are independent, big ones go to the pool
+	BigInteger left, right;
+	std::function<void()> halves[2];
+	halves[0] = [&]() { left = productTree(values, split); };
+	halves[1] = [&]() { right = productTree(values + split, count - split); };
+	runTasks(halves, 2, parallelFor(total/2));
+
+	left *= right;
+	return left;
+}
+
+//
+// binary serialization
+//
+static const std::size_t SerialHeaderSize = 16;
+#if !defined(BIGINTEGER_LIMB_BITS)
+static const unsigned char SerialLimbKind = 0;
+#else
+static const unsigned char SerialLimbKind = BIGINTEGER_LIMB_BITS;
+#endif
+
+static bool littleEndianHost()
+{
+	const unsigned int probe = 1;
+	return *reinterpret_cast<const unsigned char*>(&probe) == 1;
+}
+
+static void storeLittleEndian(unsigned char* output, unsigned long long value, std::size_t bytes)
+{
+	for(std::size_t index = 0; index < bytes; index++, value >>= 8)
+		output[index] = static_cast<unsigned char>(value & 0xff);
+}
+
+static unsigned long long loadLittleEndian(const unsigned char* input, std::size_t bytes)
+{
+	unsigned long long value = 0;
+	for(std::size_t index = bytes; index-- > 0;)
+		value = (value << 8) | input[index];
+	return value;
+}
+
+// checks the header, returns the limb count and the width of a limb in bytes
+static unsigned long long readSerialHeader(const unsigned char* buffer, std::size_t size, int& sign, std::size_t& limb_bytes)
+{
+	if(size < SerialHeaderSize || buffer[0] != 'B' || buffer[1] != 'I')
+		throw "BigInteger::deserialize -> not a serialized BigInteger";
+	if(buffer[2] != BigInteger::SerialVersion)
+		throw "BigInteger::deserialize -> unsupported version";
+
+	switch(buffer[3])
+	{
+		case 0:
+		case 32:
+			limb_bytes = 4;
+			break;
+		case 64:
+			limb_bytes = 8;
+			break;
+		default:
+			throw "BigInteger::deserialize -> unknown limb kind";
+	}
+
+	switch(buffer[4])
+	{
+		case 0:
+			sign = 0;
+			break;
+		case 1:
+			sign = 1;
+			break;
+		case 0xff:
+			sign = -1;
+			break;
+		default:
+			throw "BigInteger::deserialize -> bad sign byte";
+	}
+
+	unsigned long long count = loadLittleEndian(buffer + 8, 8);
+	if(count > (size - SerialHeaderSize) / limb_bytes)
+		throw "BigInteger::deserialize -> truncated buffer";
+	if((sign == 0) != (count == 0))
+		throw "BigInteger::deserialize -> sign and length disagree";
+
+	return count;
+}
+
+std::size_t BigInteger::serializedSize() const
+{
+	return SerialHeaderSize + storage.size()*sizeof(BaseType);
+}
+
+std::size_t BigInteger::serialize(unsigned char* buffer, std::size_t size) const
+{
+	std::size_t total = serializedSize();
+	if(size < total)
+		throw "BigInteger::serialize -> buffer too small";
+
+	buffer[0] = 'B';
+	buffer[1] = 'I';
+	buffer[2] = SerialVersion;
+	buffer[3] = SerialLimbKind;
+	buffer[4] = (sign == NEGATIVE) ? 0xff : static_cast<unsigned char>(sign);
+	buffer[5] = buffer[6] = buffer[7] = 0;
+	storeLittleEndian(buffer + 8, storage.size(), 8);
+
+	// the limbs are little endian in memory already on most hosts
+	unsigned char* output = buffer + SerialHeaderSize;
+	if(littleEndianHost())
+		std::memcpy(output, storage.data(), storage.size()*sizeof(BaseType));
+	else
+	{
+		for(std::size_t index = 0; index < storage.size(); index++)
+			storeLittleEndian(output + index*sizeof(BaseType), storage[index], sizeof(BaseType));
+	}
+
+	return total;
+}
+
+BigInteger BigInteger::deserialize(const unsigned char* buffer, std::size_t size)
+{
+	int serialSign;
+	std::size_t limb_bytes;
+	std::size_t count = static_cast<std::size_t>(readSerialHeader(buffer, size, serialSign, limb_bytes));
+	const unsigned char* input = buffer + SerialHeaderSize;
+
+	// decimal and binary limbs hold different values, they can't be mixed
+	if((buffer[3] == 0) != (SerialLimbKind == 0))
+		throw "BigInteger::deserialize -> limb kind mismatch";
+
+	BigInteger result;
+	if(limb_bytes == sizeof(BaseType))
+	{
+		result.storage.resize(count);
+		if(littleEndianHost())
+			std::memcpy(result.storage.data(), input, count*sizeof(BaseType));
+		else
+		{
+			for(std::size_t index = 0; index < count; index++)
+				result.storage[index] = static_cast<BaseType>(loadLittleEndian(input + index*limb_bytes, limb_bytes));
+		}
+	}
+	else if(limb_bytes < sizeof(BaseType))
+	{
+		// 32 bit limbs into 64 bit ones, pairs are joined
+		result.storage.resize((count+1)/2);
+		for(std::size_t index = 0; index < count; index++)
+			result.storage[index/2] |= static_cast<BaseType>(loadLittleEndian(input + index*limb_bytes, limb_bytes)) << (32*(index%2));
+	}
+	else
+	{
+		// 64 bit limbs into 32 bit ones, each one is split
+		result.storage.resize(2*count);
+		for(std::size_t index = 0; index < count; index++)
+		{
+			unsigned long long limb = loadLittleEndian(input + index*limb_bytes, limb_bytes);
+			result.storage[2*index] = static_cast<BaseType>(limb & 0xffffffffULL);
+			result.storage[2*index+1] = static_cast<BaseType>(limb >> 32);
+		}
+	}
+
+#if !defined(BIGINTEGER_LIMB_BITS)
+	for(std::size_t index = 0; index < result.storage.size(); index++)
+	{
+		if(result.storage[index] >= BigInteger::Base)
+			throw "BigInteger::deserialize -> limb out of range";
+	}
+#endif
+
+	// a sender with wider limbs may leave a zero top half
+	result.sign = static_cast<Sign>(serialSign);
+	result.removeTrailingZeros();
+	if(result.isZero() != (serialSign == 0))
+		throw "BigInteger::deserialize -> sign and length disagree";
+	return result;
+}
+
+//
+// views
+//
+BigInteger::BigInteger(const BigIntegerView& input) : sign(input.sign), storage(input.limbs, input.limbs + input.count)
+{
+}
+
+BigIntegerView::BigIntegerView(const BigInteger& input) : sign(input.sign), limbs(input.storage.data()), count(input.storage.size())
+{
+}
+
+BigIntegerView::BigIntegerView(const unsigned char* buffer, std::size_t size)
+{
+	int serialSign;
+	std::size_t limb_bytes;
+	unsigned long long serialCount = readSerialHeader(buffer, size, serialSign, limb_bytes);
+
+	if(buffer[3] != SerialLimbKind)
+		throw "BigIntegerView::BigIntegerView -> limb kind mismatch";
+	if(!littleEndianHost())
+		throw "BigIntegerView::BigIntegerView -> big endian hosts have to deserialize";
+
+	const unsigned char* input = buffer + SerialHeaderSize;
+	if(reinterpret_cast<std::size_t>(input) % sizeof(BigInteger::BaseType) != 0)
+		throw "BigIntegerView::BigIntegerView -> limbs are not aligned";
+
+	sign = static_cast<BigInteger::Sign>(serialSign);
+	limbs = reinterpret_cast<const BigInteger::BaseType*>(input);
+	count = static_cast<std::size_t>(serialCount);
+	if(count != 0 && limbs[count-1] == 0)
+		throw "BigIntegerView::BigIntegerView -> limbs are not normalized";
+}
+
+bool BigIntegerView::iszero() const
+{
+	return sign == BigInteger::ZERO;
+}
+
+std::size_t BigIntegerView::size() const
+{
+	return count;
+}
+
+const BigInteger::BaseType* BigIntegerView::data() const
+{
+	return limbs;
+}
+
+int BigIntegerView::compare(const BigIntegerView& rhs) const
+{
+	if(sign != rhs.sign)
+		return (sign > rhs.sign) ? 1 : -1;
+
+	// same sign, the magnitude order flips for negative values
+	return compareLimbs(limbs, count, rhs.limbs, rhs.count) * static_cast<int>(sign);
+}
+
+bool BigIntegerView::operator > (const BigIntegerView& rhs) const
+{
+	return compare(rhs) > 0;
+}
+
+bool BigIntegerView::operator == (const BigIntegerView& rhs) const
+{
+	return compare(rhs) == 0;
+}
+
+bool BigIntegerView::operator < (const BigIntegerView& rhs) const
+{
+	return compare(rhs) < 0;
+}
+
+bool BigIntegerView::operator >= (const BigIntegerView& rhs) const
+{
+	return compare(rhs) >= 0;
+}
+
+bool BigIntegerView::operator != (const BigIntegerView& rhs) const
+{
+	return compare(rhs) != 0;
+}
+
+bool BigIntegerView::operator <= (const BigIntegerView& rhs) const
+{
+	return compare(rhs) <= 0;
+}
+
+BigInteger BigIntegerView::operator + (const BigIntegerView& rhs) const
+{
+	return combine(rhs, false);
+}
+
+BigInteger BigIntegerView::operator - (const BigIntegerView& rhs) const
+{
+	return combine(rhs, true);
+}
+
+BigInteger BigIntegerView::combine(const BigIntegerView& rhs, bool negate) const
+{
+	BigInteger::Sign rhs_sign = negate ? static_cast<BigInteger::Sign>(-rhs.sign) : rhs.sign;
+	BigInteger result;
+
+	if(rhs_sign == BigInteger::ZERO)
+		return BigInteger(*this);
+	if(sign == BigInteger::ZERO)
+	{
+		result = BigInteger(rhs);
+		result.sign = rhs_sign;
+		return result;
+	}
+
+	const BigIntegerView *lh_obj = this, *rh_obj = &rhs;
+	BigInteger::Sign lh_sign = sign;
+	int order = compareLimbs(limbs, count, rhs.limbs, rhs.count);
+	if(order < 0)
+	{
+		lh_obj = &rhs;
+		rh_obj = this;
+		lh_sign = rhs_sign;
+	}
+
+	// the result never aliases the views, so the kernels write it directly
+	if(sign == rhs_sign)
+	{
+		result.storage.resize(lh_obj->count + 1);
+		result.storage.back() = addLimbs(result.storage.data(), lh_obj->limbs, lh_obj->count, rh_obj->limbs, rh_obj->count);
+	}
+	else
+	{
+		if(order == 0)
+			return result;
+		result.storage.resize(lh_obj->count);
+		subtractLimbs(result.storage.data(), lh_obj->limbs, lh_obj->count, rh_obj->limbs, rh_obj->count);
+	}
+
+	result.sign = lh_sign;
+	result.removeTrailingZeros();
+	return result;
+}
+
+BigInteger BigIntegerView::operator * (const BigIntegerView& rhs) const
+{
+	BigInteger result;
+	if(iszero() || rhs.iszero())
+		return result;
+
+	const BigIntegerView *lh_obj = this, *rh_obj = &rhs;
+	if(count < rhs.count)
+	{
+		lh_obj = &rhs;
+		rh_obj = this;
+	}
+
+	// two views of the same limbs make a square
+	const bool squaring = (limbs == rhs.limbs && count == rhs.count);
+
+	// toom-3 and the transform work on BigInteger operands, at those sizes
+	// copying the limbs costs next to nothing against the product
+	if(rh_obj->count >= (squaring ? BigInteger::ToomCook3SquareThreshold : BigInteger::ToomCook3Threshold))
+	{
+		if(squaring)
+		{
+			BigInteger operand(*this);
+			result.multiply(operand, operand);
+		}
+		else
+			result.multiply(BigInteger(*this), BigInteger(rhs));
+		return result;
+	}
+
+	BigInteger::Storage scratch(karatsubaScratchSize(lh_obj->count));
+	result.storage.resize(lh_obj->count + rh_obj->count);
+	if(squaring)
+		karatsubaSquareLimbs(result.storage.data(), limbs, count, scratch.data());
+	else
+		karatsubaLimbs(result.storage.data(), lh_obj->limbs, lh_obj->count, rh_obj->limbs, rh_obj->count, scratch.data());
+
+	result.sign = static_cast<BigInteger::Sign>(sign * rhs.sign);
+	result.removeTrailingZeros();
+	return result;
+}
+
+BigInteger BigIntegerView::operator / (const BigIntegerView& rhs) const
+{
+	BigInteger quotient;
+	divide(rhs, &quotient, 0);
+	return quotient;
+}
+
+BigInteger BigIntegerView::operator % (const BigIntegerView& rhs) const
+{
+	BigInteger remainder;
+	divide(rhs, 0, &remainder);
+	return remainder;
+}
+
+void BigIntegerView::divide(const BigIntegerView& rhs, BigInteger* quotient, BigInteger* remainder) const
+{
+	if(rhs.iszero())
+		throw "BigIntegerView::divide -> divide by zero";
+
+	if(iszero() || compareLimbs(limbs, count, rhs.limbs, rhs.count) < 0)
+	{
+		if(remainder != 0)
+			*remainder = BigInteger(*this);
+		return;
+	}
+
+	// the recursive methods work on BigInteger operands, their inputs are
+	// long enough that the copy doesn't matter
+	if(rhs.count >= BigInteger::BurnikelZieglerThreshold && count - rhs.count + 1 >= BigInteger::BurnikelZieglerThreshold)
+	{
+		BigInteger q, r;
+		BigInteger::divmod(BigInteger(*this), BigInteger(rhs), q, r);
+		if(quotient != 0)
+			*quotient = std::move(q);
+		if(remainder != 0)
+			*remainder = std::move(r);
+		return;
+	}
+
+	BigInteger q, r;
+	q.storage.resize(count - rhs.count + 1);
+	r.storage.resize(rhs.count);
+	if(rhs.count == 1)
+		r.storage[0] = divideSmall(q.storage.data(), limbs, count, rhs.limbs[0]);
+	else
+		divideLimbs(q.storage.data(), r.storage.data(), limbs, count, rhs.limbs, rhs.count);
+
+	// truncate toward zero, the remainder takes the sign of the dividend
+	q.sign = static_cast<BigInteger::Sign>(sign * rhs.sign);
+	q.removeTrailingZeros();
+	r.sign = sign;
+	r.removeTrailingZeros();
+
+	if(quotient != 0)
+		*quotient = std::move(q);
+	if(remainder != 0)
+		*remainder = std::move(r);
+}
+
+//
+// batches
+//
+// A row holds limb i of every value in the batch, so the kernels walk a row
+// with one carry per lane. A signed sum adds the complement of the second
+// magnitude where the signs differ; a lane that ends without a carry went
+// below zero and is complemented once more, as in two's complement.
+//
+
+// the operations combineSpans() runs
+enum BatchOperation { BatchAdd, BatchSubtract, BatchMultiply };
+
+// result = lhs + rhs + carry per lane from lane on, where flip is set rhs is
+// replaced by its complement Base-1-rhs; flip and carry hold 0 or 1, result
+// may alias lhs or rhs
+static void addLanesFrom(BaseType* result, const BaseType* lhs, const BaseType* rhs, const BaseType* flip, BaseType* carry, std::size_t count, std::size_t lane)
+{
+	for(; lane < count; lane++)
+	{
+		BaseType mask = static_cast<BaseType>(0) - flip[lane];
+#if !defined(BIGINTEGER_LIMB_BITS)
+		BaseType addend = (rhs[lane] & ~mask) | ((BigInteger::Base - 1 - rhs[lane]) & mask);
+		BaseType sum = lhs[lane] + addend + carry[lane];
+		carry[lane] = (sum >= BigInteger::Base) ? 1 : 0;
+		result[lane] = sum - carry[lane]*BigInteger::Base;
+#else
+		BaseType addend = rhs[lane] ^ mask;
+		BaseType sum = lhs[lane] + addend;
+		BaseType overflow = (sum < addend) ? 1 : 0;
+		result[lane] = sum + carry[lane];
+		carry[lane] = overflow | ((result[lane] < sum) ? 1 : 0);
+#endif
+	}
+}
+
+#if !defined(BIGINTEGER_LIMB_BITS) || BIGINTEGER_LIMB_BITS == 32
+// low (+ high) += lhs * rhs per lane from lane on, split as in
+// multiplyRowFrom(): binary products leave their top 32 bits in high, which
+// belongs to the next column
+static void multiplyLanesFrom(DoubleBaseType* low, DoubleBaseType* high, const BaseType* lhs, const BaseType* rhs, std::size_t count, std::size_t lane)
+{
+	for(; lane < count; lane++)
+	{
+		DoubleBaseType product = static_cast<DoubleBaseType>(lhs[lane]) * rhs[lane];
+#if !defined(BIGINTEGER_LIMB_BITS)
+		low[lane] += product;
+		(void)high;
+#else
+		low[lane] += static_cast<BaseType>(product);
+		high[lane] += product >> 32;
+#endif
+	}
+}
+#endif
+
+static void addLanesScalar(BaseType* result, const BaseType* lhs, const BaseType* rhs, const BaseType* flip, BaseType* carry, std::size_t count)
+{
+	addLanesFrom(result, lhs, rhs, flip, carry, count, 0);
+}
+
+#if !defined(BIGINTEGER_LIMB_BITS) || BIGINTEGER_LIMB_BITS == 32
+static void multiplyLanesScalar(DoubleBaseType* low, DoubleBaseType* high, const BaseType* lhs, const BaseType* rhs, std::size_t count)
+{
+	multiplyLanesFrom(low, high, lhs, rhs, count, 0);
+}
+#endif
+
+#ifdef BIGINTEGER_X86_SIMD
+__attribute__((target("avx2")))
+static void addLanesAVX2(BaseType* result, const BaseType* lhs, const BaseType* rhs, const BaseType* flip, BaseType* carry, std::size_t count)
+{
+	std::size_t lane = 0;
+	for(; lane + AVX2Lanes <= count; lane += AVX2Lanes)
+	{
+		__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs + lane));
+		__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs + lane));
+		__m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(carry + lane));
+		__m256i mask = AVX2_LANE(_mm256_sub)(_mm256_setzero_si256(), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(flip + lane)));
+#if !defined(BIGINTEGER_LIMB_BITS)
+		// decimal sums stay far below the sign bit
+		__m256i top = AVX2_SET1(BigInteger::Base - 1);
+		b = _mm256_or_si256(_mm256_andnot_si256(mask, b), _mm256_and_si256(mask, AVX2_LANE(_mm256_sub)(top, b)));
+		__m256i sum = AVX2_LANE(_mm256_add)(AVX2_LANE(_mm256_add)(a, b), c);
+		__m256i over = AVX2_LANE(_mm256_cmpgt)(sum, top);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(result + lane), AVX2_LANE(_mm256_sub)(sum, _mm256_and_si256(over, AVX2_SET1(BigInteger::Base))));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(carry + lane), _mm256_and_si256(over, AVX2_SET1(1)));
+#else
+		// unsigned comparisons through the signed ones with flipped top bits
+		__m256i bias = AVX2_SET1(static_cast<BaseType>(1) << (sizeof(BaseType)*8 - 1));
+		b = _mm256_xor_si256(b, mask);
+		__m256i sum = AVX2_LANE(_mm256_add)(a, b);
+		__m256i total = AVX2_LANE(_mm256_add)(sum, c);
+		__m256i overflow = AVX2_LANE(_mm256_cmpgt)(_mm256_xor_si256(b, bias), _mm256_xor_si256(sum, bias));
+		__m256i wrapped = AVX2_LANE(_mm256_cmpgt)(_mm256_xor_si256(sum, bias), _mm256_xor_si256(total, bias));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(result + lane), total);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(carry + lane), _mm256_and_si256(_mm256_or_si256(overflow, wrapped), AVX2_SET1(1)));
+#endif
+	}
+
+	addLanesFrom(result, lhs, rhs, flip, carry, count, lane);
+}
+
+#if !defined(BIGINTEGER_LIMB_BITS) || BIGINTEGER_LIMB_BITS == 32
+// the limbs are widened to 64 bit lanes, so that the products come out in
+// lane order
+__attribute__((target("avx2")))
+static void multiplyLanesAVX2(DoubleBaseType* low, DoubleBaseType* high, const BaseType* lhs, const BaseType* rhs, std::size_t count)
+{
+	std::size_t lane = 0;
+	for(; lane + 4 <= count; lane += 4)
+	{
+		__m256i a = _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs + lane)));
+		__m256i b = _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs + lane)));
+		__m256i product = _mm256_mul_epu32(a, b);
+		__m256i sum = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(low + lane));
+#if !defined(BIGINTEGER_LIMB_BITS)
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(low + lane), _mm256_add_epi64(sum, product));
+#else
+		__m256i over = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(high + lane));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(low + lane), _mm256_add_epi64(sum, _mm256_and_si256(product, _mm256_set1_epi64x(0xffffffffLL))));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(high + lane), _mm256_add_epi64(over, _mm256_srli_epi64(product, 32)));
+#endif
+	}
+
+	multiplyLanesFrom(low, high, lhs, rhs, count, lane);
+}
+#endif
+
+__attribute__((target("avx512f")))
+static void addLanesAVX512(BaseType* result, const BaseType* lhs, const BaseType* rhs, const BaseType* flip, BaseType* carry, std::size_t count)
+{
+	std::size_t lane = 0;
+	for(; lane + AVX512Lanes <= count; lane += AVX512Lanes)
+	{
+		__m512i a = _mm512_loadu_si512(lhs + lane);
+		__m512i b = _mm512_loadu_si512(rhs + lane);
+		__m512i c = _mm512_loadu_si512(carry + lane);
+		unsigned flipped = AVX512_LANE_UNSIGNED(_mm512_cmpneq)(_mm512_loadu_si512(flip + lane), _mm512_setzero_si512());
+#if !defined(BIGINTEGER_LIMB_BITS)
+		__m512i top = AVX512_SET1(BigInteger::Base - 1);
+		b = AVX512_LANE(_mm512_mask_sub)(b, flipped, top, b);
+		__m512i sum = AVX512_LANE(_mm512_add)(AVX512_LANE(_mm512_add)(a, b), c);
+		unsigned over = AVX512_LANE_UNSIGNED(_mm512_cmpgt)(sum, top);
+		_mm512_storeu_si512(result + lane, AVX512_LANE(_mm512_mask_sub)(sum, over, sum, AVX512_SET1(BigInteger::Base)));
+#else
+		b = AVX512_LANE(_mm512_mask_xor)(b, flipped, b, AVX512_SET1(~static_cast<BaseType>(0)));
+		__m512i sum = AVX512_LANE(_mm512_add)(a, b);
+		__m512i total = AVX512_LANE(_mm512_add)(sum, c);
+		unsigned over = AVX512_LANE_UNSIGNED(_mm512_cmplt)(sum, b) | AVX512_LANE_UNSIGNED(_mm512_cmplt)(total, sum);
+		_mm512_storeu_si512(result + lane, total);
+#endif
+		_mm512_storeu_si512(carry + lane, AVX512_LANE(_mm512_maskz_mov)(over, AVX512_SET1(1)));
+	}
+
+	addLanesFrom(result, lhs, rhs, flip, carry, count, lane);
+}
+
+#endif
+
+// the lane kernels picked for this cpu, on first use
+struct LaneKernels
+{
+	void (*add)(BaseType*, const BaseType*, const BaseType*, const BaseType*, BaseType*, std::size_t);
+#if !defined(BIGINTEGER_LIMB_BITS) || BIGINTEGER_LIMB_BITS == 32
+	void (*multiply)(DoubleBaseType*, DoubleBaseType*, const BaseType*, const BaseType*, std::size_t);
+#endif
+};
+
+static LaneKernels selectLaneKernels()
+{
+	LaneKernels kernels;
+	kernels.add = addLanesScalar;
+#if !defined(BIGINTEGER_LIMB_BITS) || BIGINTEGER_LIMB_BITS == 32
+	kernels.multiply = multiplyLanesScalar;
+#endif
+
+#ifdef BIGINTEGER_X86_SIMD
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx512f"))
+	{
+		// the products stay on avx2, wider ones gain next to nothing
+		kernels.add = addLanesAVX512;
+#if !defined(BIGINTEGER_LIMB_BITS) || BIGINTEGER_LIMB_BITS == 32
+		kernels.multiply = multiplyLanesAVX2;
+#endif
+	}
+	else if(__builtin_cpu_supports("avx2"))
+	{
+		kernels.add = addLanesAVX2;
+#if !defined(BIGINTEGER_LIMB_BITS) || BIGINTEGER_LIMB_BITS == 32
+		kernels.multiply = multiplyLanesAVX2;
+#endif
+	}
+#endif
+
+	return kernels;
+}
+
+static const LaneKernels& laneKernels()
+{
+	static const LaneKernels kernels = selectLaneKernels();
+	return kernels;
+}
+
+static void addLanes(BaseType* result, const BaseType* lhs, const BaseType* rhs, const BaseType* flip, BaseType* carry, std::size_t count)
+{
+	laneKernels().add(result, lhs, rhs, flip, carry, count);
+}
+
+// values per batch in the span functions, small enough that a batch
+// stays in cache while it is packed, run and unpacked
+static const std::size_t BatchTileLanes = 512;
+
+// lanes per block of the batch multiplication, their column accumulators
+// stay in cache
+static const std::size_t BatchBlockLanes = 256;
+
+// orders the pairs by the size of their longer value, stable, so that a
+// run of them makes a batch with little padding; the pairs longer than
+// MaxClassWidth come last, returns how many come before them
+static std::size_t sortBySize(const BigInteger* lhs, const BigInteger* rhs, std::size_t count, std::vector<std::size_t>& order)
+{
+	const std::size_t classes = BigIntegerBatch::MaxClassWidth + 2;
+	std::vector<std::size_t> sizes(count), starts(classes+1, 0);
+	for(std::size_t index = 0; index < count; index++)
+	{
+		sizes[index] = std::min(std::max(BigIntegerView(lhs[index]).size(), BigIntegerView(rhs[index]).size()), classes-1);
+		starts[sizes[index]+1]++;
+	}
+
+	for(std::size_t size = 0; size < classes; size++)
+		starts[size+1] += starts[size];
+	std::size_t narrow = starts[classes-1];
+	order.resize(count);
+	for(std::size_t index = 0; index < count; index++)
+		order[starts[sizes[index]]++] = index;
+	return narrow;
+}
+
+BigIntegerBatch::BigIntegerBatch() : count(0), columns(0)
+{
+}
+
+BigIntegerBatch::BigIntegerBatch(std::size_t size, std::size_t width) : count(0), columns(0)
+{
+	resize(size, width);
+}
+
+BigIntegerBatch::BigIntegerBatch(const BigInteger* values, std::size_t size) : count(0), columns(0)
+{
+	std::size_t width = 0;
+	for(std::size_t index = 0; index < size; index++)
+		width = std::max(width, values[index].storage.size());
+
+	resize(size, width);
+	for(std::size_t index = 0; index < size; index++)
+		set(index, values[index]);
+}
+
+void BigIntegerBatch::resize(std::size_t size, std::size_t width)
+{
+	count = size;
+	columns = width;
+	limbs.assign(size*width, 0);
+	signs.assign(size, 0);
+}
 
-			// add as +LARGE +SMALL
-			add(-(*lh_obj), *rh_obj);
-			//*this = -(*this);
-			operator - ();
-		}
-	}
+std::size_t BigIntegerBatch::size() const
+{
+	return count;
+}
 
-	// negate the result when lhs and rhs are swapped
-	if(lh_obj != &lhs)
-		operator - ();
+std::size_t BigIntegerBatch::width() const
+{
+	return columns;
+}
 
-	removeTrailingZeros();
+void BigIntegerBatch::set(std::size_t index, const BigInteger& value)
+{
+	std::size_t size = value.storage.size();
+	if(size > columns)
+		throw "BigIntegerBatch::set -> value wider than the batch";
+
+	const BaseType* source = value.storage.data();
+	for(std::size_t limb = 0; limb < size; limb++)
+		limbs[limb*count + index] = source[limb];
+	for(std::size_t limb = size; limb < columns; limb++)
+		limbs[limb*count + index] = 0;
+	signs[index] = static_cast<signed char>(value.sign);
+}
 
-	#ifdef DEBUG_SUBTRACT
-	std::cout << "=====" << std::endl;
-	#endif
+void BigIntegerBatch::get(std::size_t index, BigInteger& value) const
+{
+	std::size_t top = columns;
+	while(top > 0 && limbs[(top-1)*count + index] == 0)
+		top--;
+
+	value.storage.resize(top);
+	BaseType* target = value.storage.data();
+	for(std::size_t limb = 0; limb < top; limb++)
+		target[limb] = limbs[limb*count + index];
+	value.sign = (top == 0) ? BigInteger::ZERO : static_cast<BigInteger::Sign>(signs[index]);
 }
 
-void BigInteger::multiply(const BigInteger& lhs, const BigInteger& rhs)
+BigInteger BigIntegerBatch::operator [] (std::size_t index) const
 {
-	#ifdef DEBUG_MULTIPLY
-	std::cout << "=====" << std::endl;
-	std::cout << "multiply() called" << std::endl;
-	#endif
+	BigInteger value;
+	get(index, value);
+	return value;
+}
 
-	// empty the storage for new value
-	storage.clear();
+void BigIntegerBatch::add(const BigIntegerBatch& lhs, const BigIntegerBatch& rhs, BigIntegerBatch& result)
+{
+	combine(lhs, rhs, result, false);
+}
 
-	// set as 0 if either of them is 0
-	if(lhs.isZero() || rhs.isZero())
+void BigIntegerBatch::subtract(const BigIntegerBatch& lhs, const BigIntegerBatch& rhs, BigIntegerBatch& result)
+{
+	combine(lhs, rhs, result, true);
+}
+
+void BigIntegerBatch::combine(const BigIntegerBatch& lhs, const BigIntegerBatch& rhs, BigIntegerBatch& result, bool negate)
+{
+	if(lhs.count != rhs.count)
+		throw "BigIntegerBatch::combine -> batches differ in size";
+
+	// a result that is also an operand is built aside
+	BigIntegerBatch buffer;
+	BigIntegerBatch& output = (&result == &lhs || &result == &rhs) ? buffer : result;
+	std::size_t size = lhs.count, width = std::max(lhs.columns, rhs.columns);
+	output.resize(size, width+1);
+
+	// a zero takes the sign of the other value, its magnitude adds nothing
+	std::vector<BaseType> zeros(size, 0), flip(size), carry(size);
+	for(std::size_t lane = 0; lane < size; lane++)
 	{
-		sign = BigInteger::ZERO;
-		return;
+		int lh_sign = lhs.signs[lane], rh_sign = negate ? -rhs.signs[lane] : rhs.signs[lane];
+		if(lh_sign == 0)
+			lh_sign = rh_sign;
+		else if(rh_sign == 0)
+			rh_sign = lh_sign;
+
+		flip[lane] = (lh_sign != rh_sign) ? 1 : 0;
+		carry[lane] = flip[lane];
+		output.signs[lane] = static_cast<signed char>(lh_sign);
 	}
-	else if((lhs.sign==BigInteger::POSITIVE && rhs.sign==BigInteger::NEGATIVE) ||
-		    (lhs.sign==BigInteger::NEGATIVE && rhs.sign==BigInteger::POSITIVE))
+
+	for(std::size_t row = 0; row < width; row++)
 	{
-		sign = BigInteger::NEGATIVE;
+		const BaseType* a = (row < lhs.columns) ? lhs.limbs.data() + row*size : zeros.data();
+		const BaseType* b = (row < rhs.columns) ? rhs.limbs.data() + row*size : zeros.data();
+		addLanes(output.limbs.data() + row*size, a, b, flip.data(), carry.data(), size);
 	}
-	else
-		sign = BigInteger::POSITIVE;
 
-	const BigInteger *lh_obj, *rh_obj;
-	// have the larger one on the left side
-	if(compareMagnitude(lhs, rhs) == BigInteger::LESS)
+	// sums keep their carry in the top row, differences without one went
+	// below zero and are complemented back
+	BaseType* top = output.limbs.data() + width*size;
+	BaseType negative = 0;
+	for(std::size_t lane = 0; lane < size; lane++)
 	{
-		lh_obj = &rhs;
-		rh_obj = &lhs;
+		top[lane] = carry[lane] & (flip[lane] ^ 1);
+		flip[lane] &= carry[lane] ^ 1;
+		carry[lane] = flip[lane];
+		negative |= flip[lane];
+		output.signs[lane] = static_cast<signed char>(flip[lane] ? -output.signs[lane] : output.signs[lane]);
 	}
-	else
+	if(negative != 0)
 	{
-		lh_obj = &lhs;
-		rh_obj = &rhs;
+		for(std::size_t row = 0; row < width; row++)
+			addLanes(output.limbs.data() + row*size, zeros.data(), output.limbs.data() + row*size, flip.data(), carry.data(), size);
 	}
 
-	#ifdef DEBUG_MULTIPLY
-	std::cout << "lh_obj: " << *lh_obj << "; rh_obj: " << *rh_obj << std::endl;
-	#endif
+	// zero magnitudes lose their sign
+	std::fill(carry.begin(), carry.end(), 0);
+	for(std::size_t row = 0; row <= width; row++)
+	{
+		const BaseType* limb = output.limbs.data() + row*size;
+		for(std::size_t lane = 0; lane < size; lane++)
+			carry[lane] |= limb[lane];
+	}
+	for(std::size_t lane = 0; lane < size; lane++)
+		output.signs[lane] = static_cast<signed char>((carry[lane] != 0) ? output.signs[lane] : 0);
+
+	if(&output != &result)
+	{
+		result.limbs.swap(output.limbs);
+		result.signs.swap(output.signs);
+		result.count = output.count;
+		result.columns = output.columns;
+	}
+}
 
-	// reserve the storage to maximum size
-	storage.reserve(lh_obj->storage.size() + rh_obj->storage.size());
+void BigIntegerBatch::multiply(const BigIntegerBatch& lhs, const BigIntegerBatch& rhs, BigIntegerBatch& result)
+{
+	if(lhs.count != rhs.count)
+		throw "BigIntegerBatch::multiply -> batches differ in size";
 
-	#ifdef DEBUG_MULTIPLY
-	std::cout << "storage space reserve complete" << std::endl;
-	#endif
+	BigIntegerBatch buffer;
+	BigIntegerBatch& output = (&result == &lhs || &result == &rhs) ? buffer : result;
+	std::size_t size = lhs.count;
+	output.resize(size, lhs.columns + rhs.columns);
 
-	int storageIndex, lh_size = lh_obj->storage.size(), rh_size = rh_obj->storage.size();
-	BaseType carry = 0, buffer;
-	// start multiplying and push the result back
-	for(int lowerIndex = 0; lowerIndex<rh_size; lowerIndex++)
+	// schoolbook on blocks of lanes, one row of lhs against all of rhs at
+	// a time
+	for(std::size_t first = 0; first < size; first += BatchBlockLanes)
 	{
-		storageIndex = lowerIndex;
-		for(int upperIndex = 0; upperIndex<lh_size; upperIndex++)
+		std::size_t lanes = std::min(BatchBlockLanes, size - first);
+		BaseType* target = output.limbs.data() + first;
+#if !defined(BIGINTEGER_LIMB_BITS) || BIGINTEGER_LIMB_BITS == 32
+		std::size_t width = output.columns;
+		// the products are summed per column and carried once at the end,
+		// binary ones split as in multiplyRowFrom(), the top half belongs to
+		// the next column
+		std::vector<DoubleBaseType> low(width*lanes, 0);
+#if BIGINTEGER_LIMB_BITS == 32
+		std::vector<DoubleBaseType> high(width*lanes, 0);
+#endif
+		const LaneKernels& kernels = laneKernels();
+		for(std::size_t row = 0; row < lhs.columns; row++)
 		{
-			buffer = lh_obj->storage[upperIndex] * rh_obj->storage[lowerIndex] + carry;
-
-			if(storageIndex < storage.size())
-				buffer += storage[storageIndex];
+			const BaseType* a = lhs.limbs.data() + row*size + first;
+			for(std::size_t column = 0; column < rhs.columns; column++)
+			{
+				const BaseType* b = rhs.limbs.data() + column*size + first;
+#if BIGINTEGER_LIMB_BITS == 32
+				DoubleBaseType* over = high.data() + (row+column+1)*lanes;
+#else
+				DoubleBaseType* over = 0;
+#endif
+				kernels.multiply(low.data() + (row+column)*lanes, over, a, b, lanes);
+			}
+		}
 
-			carry = buffer/BigInteger::Base;
-			buffer %= BigInteger::Base;
+		std::vector<DoubleBaseType> carry(lanes, 0);
+		for(std::size_t column = 0; column < width; column++)
+		{
+			for(std::size_t lane = 0; lane < lanes; lane++)
+			{
+				DoubleBaseType sum = low[column*lanes + lane] + carry[lane];
+#if BIGINTEGER_LIMB_BITS == 32
+				sum += high[column*lanes + lane];
+#endif
+				target[column*size + lane] = static_cast<BaseType>(sum % BigInteger::Base);
+				carry[lane] = sum / BigInteger::Base;
+			}
+		}
+#else
+		// no wide lane products, the carries go along with every product
+		std::vector<BaseType> carry(lanes);
+		for(std::size_t row = 0; row < lhs.columns; row++)
+		{
+			const BaseType* a = lhs.limbs.data() + row*size + first;
+			std::fill(carry.begin(), carry.end(), 0);
+			for(std::size_t column = 0; column < rhs.columns; column++)
+			{
+				const BaseType* b = rhs.limbs.data() + column*size + first;
+				BaseType* sum = target + (row+column)*size;
+				for(std::size_t lane = 0; lane < lanes; lane++)
+				{
+					DoubleBaseType product = static_cast<DoubleBaseType>(a[lane]) * b[lane] + sum[lane] + carry[lane];
+					sum[lane] = static_cast<BaseType>(product);
+					carry[lane] = static_cast<BaseType>(product >> 64);
+				}
+			}
+			std::copy(carry.begin(), carry.end(), target + (row+rhs.columns)*size);
+		}
+#endif
+	}
 
-			if(storageIndex < storage.size())
-				storage[storageIndex] = buffer;
-			else
-				storage.push_back(buffer);
+	// a zero factor leaves zero limbs behind
+	for(std::size_t lane = 0; lane < size; lane++)
+		output.signs[lane] = static_cast<signed char>(lhs.signs[lane] * rhs.signs[lane]);
 
-			storageIndex++;
-		}
+	if(&output != &result)
+	{
+		result.limbs.swap(output.limbs);
+		result.signs.swap(output.signs);
+		result.count = output.count;
+		result.columns = output.columns;
+	}
+}
 
-		if(carry != 0)
+void BigIntegerBatch::compare(const BigIntegerBatch& lhs, const BigIntegerBatch& rhs, int* results)
+{
+	if(lhs.count != rhs.count)
+		throw "BigIntegerBatch::compare -> batches differ in size";
+
+	// magnitudes from the top row down, the first unequal limb decides,
+	// done once every lane is
+	std::size_t size = lhs.count, width = std::max(lhs.columns, rhs.columns);
+	std::vector<BaseType> zeros(size, 0);
+	std::fill(results, results + size, 0);
+	for(std::size_t row = width, open = size; row-- > 0 && open != 0;)
+	{
+		const BaseType* a = (row < lhs.columns) ? lhs.limbs.data() + row*size : zeros.data();
+		const BaseType* b = (row < rhs.columns) ? rhs.limbs.data() + row*size : zeros.data();
+		open = 0;
+		for(std::size_t lane = 0; lane < size; lane++)
 		{
-			storage.push_back(carry);
-			carry = 0;
+			results[lane] = (results[lane] != 0) ? results[lane] : (a[lane] > b[lane]) - (a[lane] < b[lane]);
+			open += (results[lane] == 0) ? 1 : 0;
 		}
 	}
 
-	// using karatsuba algorithm
-	//karatsuba(lhs, rhs);
-
-	//removeTrailingZeros();
+	for(std::size_t lane = 0; lane < size; lane++)
+	{
+		int lh_sign = lhs.signs[lane], rh_sign = rhs.signs[lane];
+		results[lane] = (lh_sign != rh_sign) ? ((lh_sign > rh_sign) ? 1 : -1) : results[lane] * lh_sign;
+	}
+}
 
-	#ifdef DEBUG_MULTIPLY
-	std::cout << "=====" << std::endl;
-	#endif
+void BigIntegerBatch::add(const BigInteger* lhs, const BigInteger* rhs, BigInteger* result, std::size_t size)
+{
+	combineSpans(lhs, rhs, result, size, BatchAdd);
 }
 
-void BigInteger::divide(const BigInteger& lhs, const BigInteger& rhs)
+void BigIntegerBatch::subtract(const BigInteger* lhs, const BigInteger* rhs, BigInteger* result, std::size_t size)
 {
-	#ifdef DEBUG_DIVIDE
-	std::cout << "=====" << std::endl;
-	std::cout << "divide() called" << std::endl;
-	#endif
+	combineSpans(lhs, rhs, result, size, BatchSubtract);
+}
 
-	if (rhs.isZero())
-		throw "BigInteger::divide -> divide by zero";
+void BigIntegerBatch::multiply(const BigInteger* lhs, const BigInteger* rhs, BigInteger* result, std::size_t size)
+{
+	combineSpans(lhs, rhs, result, size, BatchMultiply);
+}
 
-	#ifdef DEBUG_DIVIDE
-	std::cout << "storage emptied" << std::endl;
-	#endif
+void BigIntegerBatch::combineSpans(const BigInteger* lhs, const BigInteger* rhs, BigInteger* result, std::size_t size, int operation)
+{
+	std::vector<std::size_t> order;
+	std::size_t narrow = sortBySize(lhs, rhs, size, order);
 
-	// case for (0/B) or (A/B while A<B, 0 since the output is a integer)
-	if(lhs.isZero() || compareMagnitude(lhs, rhs)==BigInteger::LESS)
+	// long pairs go one at a time, every pair only touches its own result,
+	// so that the batches still read their operands
+	for(std::size_t position = narrow; position < size; position++)
 	{
-		#ifdef DEBUG_DIVIDE
-		std::cout << "direct output 0, due to (0/b) or (a/b while a<b)" << std::endl;
-		#endif
-
-		operator = (0);
-		return;
+		std::size_t index = order[position];
+		if(operation == BatchAdd)
+			result[index] = lhs[index] + rhs[index];
+		else if(operation == BatchSubtract)
+			result[index] = lhs[index] - rhs[index];
+		else
+			result[index] = lhs[index] * rhs[index];
 	}
 
-	BigInteger /*result,*/ temp, lh_buf(lhs), rh_buf(rhs);
-	operator = (0);
-	Sign signBackup = rh_buf.sign;
-
-	// set the sign, and have lh_buf and rh_buf as positive
-	if(lh_buf.sign==rh_buf.sign)
+	// the batches keep their buffers from one tile to the next, the last
+	// pair of a tile is its longest
+	BigIntegerBatch left, right, output;
+	for(std::size_t first = 0; first < narrow; first += BatchTileLanes)
 	{
-		if(lh_buf.sign==BigInteger::NEGATIVE)
+		std::size_t count = std::min(BatchTileLanes, narrow - first), last = order[first+count-1];
+		std::size_t width = std::max(lhs[last].storage.size(), rhs[last].storage.size());
+		left.resize(count, width);
+		right.resize(count, width);
+		for(std::size_t lane = 0; lane < count; lane++)
 		{
-			// negate both side
-			-lh_buf;
-			-rh_buf;
+			left.set(lane, lhs[order[first+lane]]);
+			right.set(lane, rhs[order[first+lane]]);
 		}
 
-		sign = BigInteger::POSITIVE;
-	}
-	else
-	{
-		#ifdef DEBUG_DIVIDE
-		std::cout << "negative result, due to ";
-		#endif
+		if(operation == BatchMultiply)
+			multiply(left, right, output);
+		else
+			combine(left, right, output, operation == BatchSubtract);
 
-		if(lh_buf.sign==BigInteger::NEGATIVE)
-		{
-			#ifdef DEBUG_DIVIDE
-			std::cout << "lh_buf" << std::endl;
-			#endif
+		for(std::size_t lane = 0; lane < count; lane++)
+			output.get(lane, result[order[first+lane]]);
+	}
+}
 
-			-lh_buf;
-		}
-		else
-		{
-			#ifdef DEBUG_DIVIDE
-			std::cout << "rh_buf" << std::endl;
-			#endif
+void BigIntegerBatch::compare(const BigInteger* lhs, const BigInteger* rhs, int* results, std::size_t size)
+{
+	// signs and lengths settle most pairs before a limb is read, packing
+	// them into batches would cost more than it saves
+	for(std::size_t index = 0; index < size; index++)
+		results[index] = BigIntegerView(lhs[index]).compare(BigIntegerView(rhs[index]));
+}
 
-			-rh_buf;
-		}
+//
+// out-of-core arithmetic
+//
+#ifdef BIGINTEGER_MAPPED_FILES
+MappedBigInteger::MappedBigInteger(const std::string& path) : address(MAP_FAILED), length(0)
+{
+	int descriptor = open(path.c_str(), O_RDONLY);
+	if(descriptor < 0)
+		throw "MappedBigInteger::MappedBigInteger -> can't open the file";
 
-		sign = BigInteger::NEGATIVE;
+	struct stat status;
+	if(fstat(descriptor, &status) == 0 && status.st_size > 0)
+	{
+		length = static_cast<std::size_t>(status.st_size);
+		address = mmap(0, length, PROT_READ, MAP_SHARED, descriptor, 0);
 	}
+	close(descriptor);
 
-	#ifdef DEBUG_DIVIDE
-	std::cout << "variable initialized" << std::endl;
-	#endif
-
-	int magnifier_magnitude = static_cast<int>(BigInteger::BaseMagnitude10), magnifier;
-	//int magnifier_magnitude = lh_buf.getPreciseMagnitude() - rh_buf.getPreciseMagnitude(), magnifier;
+	if(address == MAP_FAILED)
+		throw "MappedBigInteger::MappedBigInteger -> can't map the file";
 
-	// group based elimination
-	while(magnifier_magnitude>=0)
+	// check the header once, so view() can't fail later
+	try
+	{
+		view();
+	}
+	catch(...)
 	{
-		magnifier = 1;
-		for(int i = magnifier_magnitude; i > 0; i--)
-			magnifier *= 10;
-		BigInteger converted_magnifier(magnifier);
+		munmap(address, length);
+		throw;
+	}
+}
 
-		#ifdef DEBUG_DIVIDE
-		std::cout << "==>m using magnifier " << converted_magnifier << std::endl;
-		#endif
+MappedBigInteger::~MappedBigInteger()
+{
+	munmap(address, length);
+}
 
-		// reset the template value
-		temp = 1;
+BigIntegerView MappedBigInteger::view() const
+{
+	return BigIntegerView(static_cast<const unsigned char*>(address), length);
+}
 
-		// reset rh_buf(with toggled sign) and temporary result
-		rh_buf = rhs;
-		rh_buf.sign = signBackup;
+// a serialized operand or result on disk, limbs are moved with pread and
+// pwrite so only the caller's chunk buffers are resident
+struct StreamFile
+{
+	int descriptor;
+	int sign;
+	std::size_t count;
 
-		if(magnifier_magnitude == 0)
-			magnifier_magnitude--;
-		else
+	StreamFile(const std::string& path, bool output) : descriptor(-1), sign(0), count(0)
+	{
+		if(!littleEndianHost())
+			throw "BigInteger -> out-of-core arithmetic needs a little endian host";
+
+		descriptor = output ? open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644) : open(path.c_str(), O_RDONLY);
+		if(descriptor < 0)
+			throw "BigInteger -> can't open the file";
+		if(output)
+			return;
+
+		struct stat status;
+		unsigned char header[SerialHeaderSize];
+		std::size_t limb_bytes;
+		if(fstat(descriptor, &status) != 0 || static_cast<std::size_t>(status.st_size) < SerialHeaderSize)
 		{
-			bool multiplied;
-			for(multiplied = false; rh_buf*converted_magnifier <= lh_buf; rh_buf *= converted_magnifier)
-			{
-				temp *= converted_magnifier;
-				multiplied = true;
-			}
-
-			if(multiplied)
-			{
-				// rh_buf is too large for this magnification rate
-				magnifier_magnitude--;
-				continue;
-			}
+			close(descriptor);
+			throw "BigInteger::deserialize -> not a serialized BigInteger";
 		}
 
-		#ifdef DEBUG_DIVIDE
-		std::cout << "> patched" << std::endl;
-		std::cout << "...rh_buf: " << rh_buf << std::endl;
-		#endif
-
-		for(; lh_buf >= rh_buf; lh_buf -= rh_buf)
+		try
 		{
-			#ifdef DEBUG_DIVIDE
-			std::cout << "> in the loop" << std::endl;
-			std::cout << "...lh_buf: " << lh_buf << std::endl;
-			std::cout << "...rh_buf: " << rh_buf << std::endl;
-			std::cout << "...temp  : " << temp << std::endl;
-			std::cout << "...result: " << result << std::endl;
-			#endif
-
-			/*result += temp;*/
-			operator += (temp);
+			transfer(header, 0, SerialHeaderSize, false);
+			count = static_cast<std::size_t>(readSerialHeader(header, static_cast<std::size_t>(status.st_size), sign, limb_bytes));
+			if(header[3] != SerialLimbKind)
+				throw "BigInteger::deserialize -> limb kind mismatch";
 		}
-
-		#ifdef DEBUG_DIVIDE
-		std::cout << "> outside the loop, before back off" << std::endl;
-		std::cout << "...lh_buf: " << lh_buf << std::endl;
-		std::cout << "...rh_buf: " << rh_buf << std::endl;
-		std::cout << "...temp  : " << temp << std::endl;
-		std::cout << "...result: " << result << std::endl;
-		#endif
-
-		if(lh_buf.isZero())
+		catch(...)
 		{
-			// divided completely, quit the loop immediately
-			break;
+			close(descriptor);
+			throw;
 		}
-
-		
 	}
 
-	// copy back the sign
-	/*
-	result.sign = sign;
-	operator = (result);
-	*/
+	~StreamFile()
+	{
+		close(descriptor);
+	}
 
-	#ifdef DEBUG_DIVIDE
-	std::cout << "=====" << std::endl;
-	#endif
-}
+	void transfer(void* buffer, std::size_t offset, std::size_t bytes, bool output)
+	{
+		char* position = static_cast<char*>(buffer);
+		while(bytes > 0)
+		{
+			ssize_t done = output ? pwrite(descriptor, position, bytes, static_cast<off_t>(offset)) : pread(descriptor, position, bytes, static_cast<off_t>(offset));
+			if(done < 0 && errno == EINTR)
+				continue;
+			if(done <= 0)
+				throw output ? "BigInteger -> write failed" : "BigInteger -> read failed";
 
-void BigInteger::modulus(const BigInteger& lhs, const BigInteger& rhs)
-{
-	#ifdef DEBUG_MODULUS
-	std::cout << "=====" << std::endl;
-	std::cout << "modulus() called" << std::endl;
-	#endif
+			position += done;
+			offset += done;
+			bytes -= done;
+		}
+	}
 
-	if(compareMagnitude(lhs, rhs) == BigInteger::LESS)
+	// limbs [offset, offset+size)
+	void read(BaseType* limbs, std::size_t offset, std::size_t size)
 	{
-		#ifdef DEBUG_MODULUS
-		std::cout << "direct output" << std::endl;
-		#endif
+		transfer(limbs, SerialHeaderSize + offset*sizeof(BaseType), size*sizeof(BaseType), false);
+	}
 
-		operator = (lhs);
+	void write(const BaseType* limbs, std::size_t offset, std::size_t size)
+	{
+		transfer(const_cast<BaseType*>(limbs), SerialHeaderSize + offset*sizeof(BaseType), size*sizeof(BaseType), true);
 	}
-	else
+
+	// the header goes last, once the normalized length is known
+	void finish(int resultSign, std::size_t resultCount)
 	{
-		#ifdef DEBUG_MODULUS
-		std::cout << "lhs/rhs = " << (lhs/rhs) << std::endl;
-		std::cout << "rhs*(lhs/rhs) = " << (rhs*(lhs/rhs)) << std::endl;
-		#endif
+		unsigned char header[SerialHeaderSize] = { 'B', 'I', BigInteger::SerialVersion, SerialLimbKind, 0, 0, 0, 0 };
+		header[4] = (resultSign < 0) ? 0xff : static_cast<unsigned char>(resultSign);
+		storeLittleEndian(header + 8, resultCount, 8);
+		transfer(header, 0, SerialHeaderSize, true);
 
-		operator = (lhs - rhs * (lhs/rhs));
+		if(ftruncate(descriptor, static_cast<off_t>(SerialHeaderSize + resultCount*sizeof(BaseType))) != 0)
+			throw "BigInteger -> write failed";
 	}
+};
 
-	#ifdef DEBUG_MODULUS
-	std::cout << "=====" << std::endl;
-	#endif
-}
-
-void BigInteger::karatsuba(const BigInteger& lhs, const BigInteger& rhs)
+// compares the magnitudes from the top, a chunk at a time
+static int streamCompare(StreamFile& lhs, StreamFile& rhs)
 {
+	if(lhs.count != rhs.count)
+		return (lhs.count > rhs.count) ? 1 : -1;
 
-}
-
-BigInteger::Compare BigInteger::compare(const BigInteger& lhs, const BigInteger& rhs) const
-{
-	// compate sign first
-	if(lhs.sign > rhs.sign)
-		return BigInteger::GREATER;
-	else if(lhs.sign < rhs.sign)
-		return BigInteger::LESS;
+	std::vector<BaseType> a(BigInteger::StreamChunkLimbs), b(BigInteger::StreamChunkLimbs);
+	for(std::size_t end = lhs.count; end > 0;)
+	{
+		std::size_t size = (end < BigInteger::StreamChunkLimbs) ? end : BigInteger::StreamChunkLimbs;
+		end -= size;
+		lhs.read(a.data(), end, size);
+		rhs.read(b.data(), end, size);
+
+		int order = compareLimbs(a.data(), size, b.data(), size);
+		if(order != 0)
+			return order;
+	}
 
-	// compare by magnitude and ajust by the sign
-	if(lhs.sign == BigInteger::POSITIVE)
-		return compareMagnitude(lhs, rhs);
-	else
-		return compareMagnitude(rhs, lhs);
+	return 0;
 }
 
-int BigInteger::getPreciseMagnitude() const
+// the result is truncated when it's opened, so it must not be a file an
+// operand is read from, under any of its names
+static void checkResultPath(const std::string& path, const StreamFile& operand)
 {
-	int result = (storage.size()-1) * BigInteger::BaseMagnitude10;
-
-	// find out the digit counts for the msg(most significant group)
-	int temp = storage.back();
-	for(; temp>0; result++, temp/=10);
-
-	return result;
+	struct stat result, input;
+	if(stat(path.c_str(), &result) != 0)
+		return;
+	if(fstat(operand.descriptor, &input) == 0 && result.st_dev == input.st_dev && result.st_ino == input.st_ino)
+		throw "BigInteger -> the result file is one of the operands";
 }
 
-BigInteger::Compare BigInteger::compareMagnitude(const BigInteger& lhs, const BigInteger& rhs) const
+// lhs + rhs, or lhs - rhs when negate is set, through chunk buffers
+static void streamCombine(const std::string& lhs_path, const std::string& rhs_path, bool negate, const std::string& result_path)
 {
-	if(lhs.storage.size() > rhs.storage.size())
-		return BigInteger::GREATER;
-	else if(lhs.storage.size() < rhs.storage.size())
-		return BigInteger::LESS;
-	else
+	StreamFile lhs(lhs_path, false), rhs(rhs_path, false);
+	checkResultPath(result_path, lhs);
+	checkResultPath(result_path, rhs);
+	StreamFile result(result_path, true);
+
+	// the larger magnitude goes first, its sign is the result's sign
+	StreamFile *lh_file = &lhs, *rh_file = &rhs;
+	int lh_sign = lhs.sign, rh_sign = negate ? -rhs.sign : rhs.sign;
+	if(streamCompare(lhs, rhs) < 0)
+	{
+		std::swap(lh_file, rh_file);
+		std::swap(lh_sign, rh_sign);
+	}
+	bool subtract = (lh_sign != 0 && rh_sign != 0 && lh_sign != rh_sign);
+
+	std::vector<BaseType> a(BigInteger::StreamChunkLimbs), b(BigInteger::StreamChunkLimbs), sum(BigInteger::StreamChunkLimbs);
+	BaseType carry = 0, one = 1, next;
+	std::size_t top = 0;
+	for(std::size_t offset = 0; offset < lh_file->count; offset += BigInteger::StreamChunkLimbs)
 	{
-		for(int index = lhs.storage.size()-1; index>=0; index--)
+		std::size_t size = lh_file->count - offset, rh_size = 0;
+		if(size > BigInteger::StreamChunkLimbs)
+			size = BigInteger::StreamChunkLimbs;
+		if(offset < rh_file->count)
+			rh_size = (rh_file->count - offset < size) ? rh_file->count - offset : size;
+
+		lh_file->read(a.data(), offset, size);
+		rh_file->read(b.data(), offset, rh_size);
+
+		// the carry or borrow of the previous chunk goes in afterwards,
+		// the two can't both be set
+		if(subtract)
+		{
+			next = subtractLimbs(sum.data(), a.data(), size, b.data(), rh_size);
+			if(carry != 0)
+				next |= subtractLimbs(sum.data(), sum.data(), size, &one, 1);
+		}
+		else
+		{
+			next = addLimbs(sum.data(), a.data(), size, b.data(), rh_size);
+			if(carry != 0)
+				next |= addLimbs(sum.data(), sum.data(), size, &one, 1);
+		}
+		carry = next;
+
+		result.write(sum.data(), offset, size);
+		for(std::size_t index = size; index-- > 0;)
 		{
-			if(lhs.storage[index] > rhs.storage[index])
-				return BigInteger::GREATER;
-			else if(lhs.storage[index] < rhs.storage[index])
-				return BigInteger::LESS;
+			if(sum[index] != 0)
+			{
+				top = offset + index + 1;
+				break;
+			}
 		}
+	}
 
-		return EQUAL;
+	if(!subtract && carry != 0)
+	{
+		result.write(&carry, lh_file->count, 1);
+		top = lh_file->count + 1;
 	}
+
+	result.finish((top == 0) ? 0 : lh_sign, top);
 }
 
-bool BigInteger::isZero() const
+void BigInteger::addFiles(const std::string& lhs, const std::string& rhs, const std::string& result)
 {
-	return sign==BigInteger::ZERO;
+	streamCombine(lhs, rhs, false, result);
 }
 
-void BigInteger::removeTrailingZeros()
+void BigInteger::subtractFiles(const std::string& lhs, const std::string& rhs, const std::string& result)
 {
-	while(storage.back() == 0 && !storage.empty())
-		storage.pop_back();
+	streamCombine(lhs, rhs, true, result);
+}
 
-	// set sign flag to zero if the storage is empty
-	if(storage.empty())
-		sign = BigInteger::ZERO;
+void BigInteger::multiplyFileBySmall(const std::string& lhs, BaseType rhs, const std::string& result)
+{
+#if !defined(BIGINTEGER_LIMB_BITS)
+	if(rhs >= BigInteger::Base)
+		throw "BigInteger::multiplyFileBySmall -> factor must be below Base";
+#endif
+
+	StreamFile input(lhs, false);
+	checkResultPath(result, input);
+	StreamFile output(result, true);
+
+	std::vector<BaseType> a(StreamChunkLimbs), product(StreamChunkLimbs);
+	BaseType carry = 0;
+	std::size_t top = 0;
+	for(std::size_t offset = 0; offset < input.count; offset += StreamChunkLimbs)
+	{
+		std::size_t size = (input.count - offset < StreamChunkLimbs) ? input.count - offset : StreamChunkLimbs;
+		input.read(a.data(), offset, size);
+		carry = multiplySmall(product.data(), a.data(), size, rhs, carry);
+		output.write(product.data(), offset, size);
+
+		for(std::size_t index = size; index-- > 0;)
+		{
+			if(product[index] != 0)
+			{
+				top = offset + index + 1;
+				break;
+			}
+		}
+	}
+
+	if(carry != 0)
+	{
+		output.write(&carry, input.count, 1);
+		top = input.count + 1;
+	}
 
-	storage.shrink_to_fit();
+	output.finish((top == 0) ? 0 : input.sign, top);
 }
+#endif
@@ -1,10 +1,368 @@
 #ifndef BIGINTEGER_H
 #define BIGINTEGER_H
 
+#include <cstddef>
+#include <cstring>
 #include <iostream>
 #include <string>
+#include <utility>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
 #include <vector>
 
+// The limb layout is picked when the library is built. Leave
+// BIGINTEGER_LIMB_BITS undefined to keep the decimal base-10000 limbs, or set
+// it to 32 or 64 to store full-width binary limbs.
+#if defined(BIGINTEGER_LIMB_BITS) && BIGINTEGER_LIMB_BITS != 32 && BIGINTEGER_LIMB_BITS != 64
+#error "BIGINTEGER_LIMB_BITS must be either 32 or 64"
+#endif
+
+// the mapped storage and the out-of-core helpers need POSIX files and mmap
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(BIGINTEGER_NO_MAPPED_FILES)
+#define BIGINTEGER_MAPPED_FILES
+#endif
+
+// Source of the heap blocks behind limb storage. A storage grabs
+// LimbAllocator::current() of its thread when it first leaves the inline
+// buffer and returns the block to that same allocator, so values made under
+// different allocators can be mixed freely.
+class LimbAllocator
+{
+public:
+	virtual ~LimbAllocator() {}
+
+	virtual void* allocate(std::size_t bytes) = 0;
+	virtual void deallocate(void* block, std::size_t bytes) = 0;
+
+	// capacity policy, whether a block of capacity bytes holding only used
+	// bytes should be traded for a smaller one, by default once it is three
+	// quarters empty
+	virtual bool shouldShrink(std::size_t used, std::size_t capacity) const { return 4*used <= capacity; }
+
+	// allocator for new blocks on the calling thread, the global heap unless
+	// a LimbAllocatorScope is active
+	static LimbAllocator* current();
+	static LimbAllocator* setCurrent(LimbAllocator*);
+};
+
+// plain operator new and delete
+class HeapLimbAllocator : public LimbAllocator
+{
+public:
+	void* allocate(std::size_t bytes);
+	void deallocate(void* block, std::size_t bytes);
+
+	static HeapLimbAllocator& instance();
+};
+
+// Bump allocator over large chunks. deallocate() only takes back the latest
+// block, everything else stays until reset() or destruction discards it all
+// at once, so no value allocated from the arena may outlive that. Not thread
+// safe, use one arena per thread.
+class ArenaLimbAllocator : public LimbAllocator
+{
+public:
+	explicit ArenaLimbAllocator(std::size_t chunkBytes = 1 << 20);
+	~ArenaLimbAllocator();
+
+	void* allocate(std::size_t bytes);
+	void deallocate(void* block, std::size_t bytes);
+	// shrinking gains nothing when blocks are never reused
+	bool shouldShrink(std::size_t, std::size_t) const { return false; }
+
+	// drop every block, the first chunk is kept for reuse
+	void reset();
+	std::size_t bytesInUse() const;
+
+private:
+	struct Chunk
+	{
+		char* begin;
+		std::size_t size;
+	};
+
+	std::vector<Chunk> chunks;
+	std::size_t chunkBytes, used;
+	char* last;
+
+	ArenaLimbAllocator(const ArenaLimbAllocator&);
+	ArenaLimbAllocator& operator = (const ArenaLimbAllocator&);
+};
+
+// Power of two size classes with a free list per class, cached per thread.
+// Blocks may be freed on any thread, they join that thread's cache. Blocks
+// above the largest class go straight to the heap.
+class PoolLimbAllocator : public LimbAllocator
+{
+public:
+	static const std::size_t MinClassBytes = 64;
+	static const std::size_t MaxClassBytes = 1 << 20;
+	// free blocks kept per size class and thread
+	static const std::size_t MaxCachedBlocks = 32;
+
+	void* allocate(std::size_t bytes);
+	void deallocate(void* block, std::size_t bytes);
+
+	// give the calling thread's cached blocks back to the heap
+	static void trim();
+
+	static PoolLimbAllocator& instance();
+};
+
+#ifdef BIGINTEGER_MAPPED_FILES
+// Blocks of at least minimumBytes live in shared mappings of unlinked
+// temporary files under directory, so the kernel can write cold limbs back
+// to disk instead of keeping them resident. Smaller blocks use the heap.
+class MappedLimbAllocator : public LimbAllocator
+{
+public:
+	explicit MappedLimbAllocator(const std::string& directory = "/tmp", std::size_t minimumBytes = 1 << 20);
+
+	void* allocate(std::size_t bytes);
+	void deallocate(void* block, std::size_t bytes);
+
+private:
+	std::string directory;
+	std::size_t minimumBytes;
+};
+#endif
+
+// makes an allocator current on this thread until the end of the scope
+class LimbAllocatorScope
+{
+public:
+	explicit LimbAllocatorScope(LimbAllocator& allocator) : previous(LimbAllocator::setCurrent(&allocator)) {}
+	~LimbAllocatorScope() { LimbAllocator::setCurrent(previous); }
+
+private:
+	LimbAllocator* previous;
+
+	LimbAllocatorScope(const LimbAllocatorScope&);
+	LimbAllocatorScope& operator = (const LimbAllocatorScope&);
+};
+
+// Limb container with the interface of the std::vector subset BigInteger
+// uses. The first InlineCount limbs live inside the object, the heap is only
+// touched once a value grows past them. T must be trivially copyable.
+template <typename T, std::size_t InlineCount>
+class LimbStorage
+{
+public:
+	typedef T value_type;
+	typedef T* iterator;
+	typedef const T* const_iterator;
+
+	LimbStorage() : count(0), space(InlineCount) {}
+	explicit LimbStorage(std::size_t size, const T& value = T()) : count(0), space(InlineCount) { resize(size, value); }
+	LimbStorage(const T* first, const T* last) : count(0), space(InlineCount) { assign(first, last); }
+	LimbStorage(const LimbStorage& input) : count(0), space(InlineCount) { assign(input.begin(), input.end()); }
+	LimbStorage(LimbStorage&& input) noexcept : count(0), space(InlineCount) { take(input); }
+	~LimbStorage() { release(); }
+
+	LimbStorage& operator = (const LimbStorage& rhs)
+	{
+		if(this != &rhs)
+			assign(rhs.begin(), rhs.end());
+		return *this;
+	}
+
+	LimbStorage& operator = (LimbStorage&& rhs) noexcept
+	{
+		if(this != &rhs)
+		{
+			release();
+			take(rhs);
+		}
+		return *this;
+	}
+
+	std::size_t size() const { return count; }
+	std::size_t capacity() const { return space; }
+	bool empty() const { return count == 0; }
+	bool isInline() const { return space == InlineCount; }
+
+	T* data() { return isInline() ? local : remote.limbs; }
+	const T* data() const { return isInline() ? local : remote.limbs; }
+	T* begin() { return data(); }
+	const T* begin() const { return data(); }
+	T* end() { return data() + count; }
+	const T* end() const { return data() + count; }
+
+	T& operator [] (std::size_t index) { return data()[index]; }
+	const T& operator [] (std::size_t index) const { return data()[index]; }
+	T& front() { return data()[0]; }
+	const T& front() const { return data()[0]; }
+	T& back() { return data()[count-1]; }
+	const T& back() const { return data()[count-1]; }
+
+	void clear() { count = 0; }
+	void pop_back() { count--; }
+
+	void push_back(const T& value)
+	{
+		// value may point into the storage itself
+		T copy = value;
+		if(count == space)
+			reallocate(2*space);
+		data()[count++] = copy;
+	}
+
+	void reserve(std::size_t size)
+	{
+		if(size > space)
+			reallocate(size);
+	}
+
+	void resize(std::size_t size, const T& value = T())
+	{
+		if(size > space)
+			reallocate((size < 2*space) ? 2*space : size);
+		T* limbs = data();
+		for(std::size_t index = count; index < size; index++)
+			limbs[index] = value;
+		count = size;
+	}
+
+	void assign(const T* first, const T* last)
+	{
+		// the range may lie inside the storage, so it is read before the
+		// old block goes away
+		std::size_t size = last - first;
+		if(size > space)
+		{
+			LimbStorage fresh;
+			fresh.reallocate(size);
+			std::memcpy(fresh.data(), first, size*sizeof(T));
+			fresh.count = size;
+			swap(fresh);
+		}
+		else
+		{
+			std::memmove(data(), first, size*sizeof(T));
+			count = size;
+		}
+	}
+
+	void assign(std::size_t size, const T& value)
+	{
+		T copy = value;
+		count = 0;
+		resize(size, copy);
+	}
+
+	T* insert(T* position, std::size_t size, const T& value)
+	{
+		std::size_t index = position - data(), tail = count - index;
+		T copy = value;
+		resize(count + size);
+		T* limbs = data();
+		std::memmove(limbs + index + size, limbs + index, tail*sizeof(T));
+		for(std::size_t offset = 0; offset < size; offset++)
+			limbs[index + offset] = copy;
+		return limbs + index;
+	}
+
+	T* erase(T* first, T* last)
+	{
+		T* limbs = data();
+		std::memmove(first, last, (limbs + count - last)*sizeof(T));
+		count -= last - first;
+		return first;
+	}
+
+	void shrink_to_fit()
+	{
+		if(!isInline() && count < space)
+			reallocate(count);
+	}
+
+	// shrink only when the allocator's capacity policy asks for it
+	void trim()
+	{
+		if(!isInline() && remote.allocator->shouldShrink(count*sizeof(T), space*sizeof(T)))
+			reallocate(count);
+	}
+
+	void swap(LimbStorage& other)
+	{
+		if(!isInline() && !other.isInline())
+		{
+			std::swap(remote, other.remote);
+			std::swap(count, other.count);
+			std::swap(space, other.space);
+			return;
+		}
+
+		LimbStorage temp(std::move(other));
+		other = std::move(*this);
+		*this = std::move(temp);
+	}
+
+private:
+	struct HeapBlock
+	{
+		T* limbs;
+		LimbAllocator* allocator;
+	};
+
+	// inline while space == InlineCount, otherwise remote holds space limbs
+	std::size_t count, space;
+	union
+	{
+		T local[InlineCount];
+		HeapBlock remote;
+	};
+
+	void reallocate(std::size_t size)
+	{
+		// a block no larger than the inline buffer goes back inside
+		if(size <= InlineCount)
+		{
+			if(!isInline())
+			{
+				HeapBlock old = remote;
+				std::memcpy(local, old.limbs, count*sizeof(T));
+				old.allocator->deallocate(old.limbs, space*sizeof(T));
+				space = InlineCount;
+			}
+			return;
+		}
+
+		// a block keeps growing from the allocator it came from
+		LimbAllocator* allocator = isInline() ? LimbAllocator::current() : remote.allocator;
+		T* block = static_cast<T*>(allocator->allocate(size*sizeof(T)));
+		std::memcpy(block, data(), count*sizeof(T));
+		release();
+		remote.limbs = block;
+		remote.allocator = allocator;
+		space = size;
+	}
+
+	void release()
+	{
+		if(!isInline())
+			remote.allocator->deallocate(remote.limbs, space*sizeof(T));
+		space = InlineCount;
+	}
+
+	void take(LimbStorage& input)
+	{
+		// steal a heap block, inline limbs have to be copied, count never
+		// exceeds InlineCount there but the bound keeps that visible
+		if(input.isInline())
+			std::memcpy(local, input.local, ((input.count < InlineCount) ? input.count : InlineCount)*sizeof(T));
+		else
+			remote = input.remote;
+		count = input.count;
+		space = input.space;
+		input.count = 0;
+		input.space = InlineCount;
+	}
+};
+
+class BigIntegerView;
+
 class BigInteger
 {
 	//
@@ -14,23 +372,120 @@ private:
 	enum Sign { POSITIVE = 1, ZERO = 0, NEGATIVE = -1 };
 	enum Compare { GREATER, EQUAL, LESS };
 public:
+#if !defined(BIGINTEGER_LIMB_BITS)
 	typedef unsigned int BaseType;
+	// wide enough to hold the product of two limbs plus carries
+	typedef unsigned long long DoubleBaseType;
 	static const unsigned int Base = 10000;
 	// magnitude of the Base value, currently hard coded
 	static const unsigned int BaseMagnitude10 = 4;
+#elif BIGINTEGER_LIMB_BITS == 32
+	typedef unsigned int BaseType;
+	typedef unsigned long long DoubleBaseType;
+	static const DoubleBaseType Base = 1ULL << 32;
+#else
+	typedef unsigned long long BaseType;
+	__extension__ typedef unsigned __int128 DoubleBaseType;
+	static const DoubleBaseType Base = static_cast<DoubleBaseType>(1) << 64;
+#endif
+
+#if !defined(BIGINTEGER_LIMB_BITS)
+	// decimal text maps onto the limbs directly
+	static const BaseType IOBase = Base;
+	static const unsigned int IOBaseMagnitude10 = BaseMagnitude10;
+#elif BIGINTEGER_LIMB_BITS == 32
+	// largest power of ten that fits in a limb, used for text conversion
+	static const BaseType IOBase = 1000000000U;
+	static const unsigned int IOBaseMagnitude10 = 9;
+#else
+	static const BaseType IOBase = 10000000000000000000ULL;
+	static const unsigned int IOBaseMagnitude10 = 19;
+#endif
+
+	// limbs kept inside the object before the storage moves to the heap,
+	// enough for any value below 2^128
+#if !defined(BIGINTEGER_LIMB_BITS)
+	static const std::size_t InlineLimbs = 10;
+#elif BIGINTEGER_LIMB_BITS == 32
+	static const std::size_t InlineLimbs = 4;
+#else
+	static const std::size_t InlineLimbs = 2;
+#endif
+	typedef LimbStorage<BaseType, InlineLimbs> Storage;
+
+	// operand sizes, in limbs of the shorter operand, at which multiply()
+	// leaves the schoolbook loop for the recursive methods, and the same for
+	// squares, whose basecase does half the work; the karatsuba square
+	// threshold must not be below the product one, they share scratch sizes
+#if !defined(BIGINTEGER_LIMB_BITS)
+	static const std::size_t KaratsubaThreshold = 96;
+	static const std::size_t ToomCook3Threshold = 600;
+	static const std::size_t KaratsubaSquareThreshold = 160;
+	static const std::size_t ToomCook3SquareThreshold = 900;
+#elif BIGINTEGER_LIMB_BITS == 32
+	static const std::size_t KaratsubaThreshold = 48;
+	static const std::size_t ToomCook3Threshold = 256;
+	static const std::size_t KaratsubaSquareThreshold = 72;
+	static const std::size_t ToomCook3SquareThreshold = 384;
+#else
+	static const std::size_t KaratsubaThreshold = 40;
+	static const std::size_t ToomCook3Threshold = 200;
+	static const std::size_t KaratsubaSquareThreshold = 40;
+	static const std::size_t ToomCook3SquareThreshold = 300;
+#endif
+
+	// operand size, in limbs of the shorter operand, above which multiply()
+	// uses the number theoretic transform, adjustable at runtime
+	static std::size_t NTTThreshold;
+
+	// size, in limbs of the shorter operand, from which the recursive
+	// multiplications, the transforms and the product trees hand their
+	// independent parts to the thread pool, adjustable at runtime
+	static std::size_t ParallelThreshold;
+
+	// sizes, in limbs of the divisor and of the quotient, at which divide()
+	// leaves knuth's long division for burnikel-ziegler, and then for newton
+	// iteration on a reciprocal
+#if !defined(BIGINTEGER_LIMB_BITS)
+	static const std::size_t BurnikelZieglerThreshold = 48;
+	static const std::size_t NewtonDivisionThreshold = 4000;
+#elif BIGINTEGER_LIMB_BITS == 32
+	static const std::size_t BurnikelZieglerThreshold = 80;
+	static const std::size_t NewtonDivisionThreshold = 8000;
+#else
+	static const std::size_t BurnikelZieglerThreshold = 48;
+	static const std::size_t NewtonDivisionThreshold = 8000;
+#endif
+
+	// operand size, in limbs, from which gcd() reduces the top half of the
+	// operands recursively instead of one lehmer step at a time
+#if !defined(BIGINTEGER_LIMB_BITS)
+	static const std::size_t HalfGcdThreshold = 120;
+#elif BIGINTEGER_LIMB_BITS == 32
+	static const std::size_t HalfGcdThreshold = 160;
+#else
+	static const std::size_t HalfGcdThreshold = 200;
+#endif
 
 	//
 	// actual functions
 	//
 protected:
 	Sign sign;
-	std::vector<BaseType> storage;
+	Storage storage;
 	int getPreciseMagnitude() const;
 public:
 	BigInteger();
 	BigInteger(const int&);
 	BigInteger(const std::string&);
+	BigInteger(const char*);
+	BigInteger(const char*, std::size_t);
+#if __cplusplus >= 201703L
+	BigInteger(std::string_view);
+#endif
+	explicit BigInteger(const BigIntegerView&);
 	BigInteger(const BigInteger&);
+	BigInteger(BigInteger&&) noexcept;
 
 	// unary operator
 	void operator - ();
@@ -42,11 +497,13 @@ public:
 	void operator -- (int);
 
 	// binary operator: arithmetic
-	const BigInteger operator + (const BigInteger&) const;
-	const BigInteger operator - (const BigInteger&) const;
-	const BigInteger operator * (const BigInteger&) const;
-	const BigInteger operator / (const BigInteger&) const;
-	const BigInteger operator % (const BigInteger&) const;
+	BigInteger operator + (const BigInteger&) const &;
+	BigInteger operator + (const BigInteger&) &&;
+	BigInteger operator - (const BigInteger&) const &;
+	BigInteger operator - (const BigInteger&) &&;
+	BigInteger operator * (const BigInteger&) const;
+	BigInteger operator / (const BigInteger&) const;
+	BigInteger operator % (const BigInteger&) const;
 
 	// binary operator: arithmetic (continue)
 	BigInteger& operator += (const BigInteger&);
@@ -57,6 +514,59 @@ public:
 	BigInteger& operator /= (const int&);
 	BigInteger& operator %= (const BigInteger&);
 
+	// *this times itself, every cross product is computed once; x*x and
+	// x *= x take the same path
+	BigInteger square() const;
+
+	// quotient and remainder from a single division, truncated toward zero
+	static void divmod(const BigInteger&, const BigInteger&, BigInteger&, BigInteger&);
+
+	// base^exponent, 0^0 is 1; the base's trailing zero digits, decimal for
+	// decimal limbs and binary otherwise, come out as a shift, so powers of
+	// 10 or of 2 cost next to nothing
+	static BigInteger pow(const BigInteger&, unsigned long long);
+
+	// base^exponent modulo |modulus|, in [0, |modulus|); moduli coprime to
+	// the limb base (odd, or coprime to 10 for decimal limbs) run in
+	// montgomery form, the others reduce by division; powmodSecure() takes
+	// the same steps and memory accesses for every exponent of a given
+	// length, and only accepts moduli coprime to the limb base
+	static BigInteger powmod(const BigInteger&, const BigInteger&, const BigInteger&);
+	static BigInteger powmodSecure(const BigInteger&, const BigInteger&, const BigInteger&);
+
+	// greatest common divisor and least common multiple, never negative,
+	// gcd(0, 0) and lcm(x, 0) are 0
+	static BigInteger gcd(const BigInteger&, const BigInteger&);
+	static BigInteger lcm(const BigInteger&, const BigInteger&);
+	// g = gcd(a, b) together with a*x + b*y = g, the cofactor of the larger
+	// magnitude is the one of least magnitude, so |x| <= |b|/g and
+	// |y| <= |a|/g; x and y may be a and b
+	static BigInteger gcdext(const BigInteger&, const BigInteger&, BigInteger&, BigInteger&);
+	// the inverse of value modulo |modulus|, in [0, |modulus|), throws when
+	// the two have a common factor
+	static BigInteger invmod(const BigInteger&, const BigInteger&);
+
+	// floor(value^(1/k)), by newton iteration with the precision doubling
+	// from the leading limbs down; odd roots of negative values are
+	// negative and truncated toward zero, even ones throw
+	static BigInteger isqrt(const BigInteger&);
+	static BigInteger iroot(const BigInteger&, unsigned int);
+
+	// products of many factors, multiplied pairwise in a balanced tree so
+	// that the operands of every multiplication have about the same size;
+	// product() of an empty range is 1, binomial(n, k) is 0 for k > n and
+	// primorial(n) is the product of the primes up to n
+	static BigInteger product(const BigInteger*, const BigInteger*);
+	static BigInteger factorial(unsigned long long);
+	static BigInteger binomial(unsigned long long, unsigned long long);
+	static BigInteger primorial(unsigned long long);
+
+	// threads for large multiplications, the calling one included; 0 and 1,
+	// the default, keep everything on the calling thread. Not to be called
+	// while another thread is doing arithmetic.
+	static void setThreads(unsigned int);
+	static unsigned int threads();
+
 	// binary operator: comparison
 	bool operator > (const BigInteger&) const;
 	bool operator == (const BigInteger&) const;
@@ -68,11 +578,43 @@ public:
 
 	// binary operator: stream and memroy operation
 	BigInteger& operator = (const BigInteger&);
+	BigInteger& operator = (BigInteger&&) noexcept;
 	BigInteger& operator = (const int&);
 	friend std::ostream& operator << (std::ostream&, const BigInteger&);
 
+	// text output into a caller's buffer: charsLength() characters are
+	// always enough, exact for decimal limbs and at most one more than
+	// needed for binary ones, toChars() writes the value without a
+	// terminator and returns the end of the text, or throws when the buffer
+	// is too small
+	std::size_t charsLength() const;
+	char* toChars(char*, char*) const;
+
 	bool iseven();
 	bool iszero() const;
+	// a few residues rule out most non-squares before the root is taken
+	bool isPerfectSquare() const;
+
+	// binary wire format, a 16 byte header ("BI", version, limb kind, sign
+	// byte, three zero bytes, 64 bit limb count) and then the limbs, all
+	// little endian; serialize() returns the bytes written and throws when
+	// the buffer is too small, deserialize() accepts either binary limb width
+	static const unsigned char SerialVersion = 1;
+	std::size_t serializedSize() const;
+	std::size_t serialize(unsigned char*, std::size_t) const;
+	static BigInteger deserialize(const unsigned char*, std::size_t);
+
+#ifdef BIGINTEGER_MAPPED_FILES
+	// out-of-core arithmetic between files written by serialize(), operands
+	// are read and the result written StreamChunkLimbs limbs at a time, so
+	// memory use doesn't grow with their length; a result file that is one
+	// of the operands throws before anything is written, multiplyFileBySmall
+	// needs a factor below Base
+	static const std::size_t StreamChunkLimbs = 1 << 16;
+	static void addFiles(const std::string&, const std::string&, const std::string&);
+	static void subtractFiles(const std::string&, const std::string&, const std::string&);
+	static void multiplyFileBySmall(const std::string&, BaseType, const std::string&);
+#endif
 
 	//
 	// support functions
@@ -84,7 +626,60 @@ private:
 	void divide(const BigInteger&, const BigInteger&);
 	void modulus(const BigInteger&, const BigInteger&);
 
+	// the division helpers work on magnitudes, *this gets the quotient
+	void divideMagnitude(const BigInteger&, const BigInteger&, BigInteger&);
+	void divideKnuth(const BigInteger&, const BigInteger&, BigInteger&);
+	void divideBurnikelZiegler(const BigInteger&, const BigInteger&, BigInteger&);
+	void divide2n1n(const BigInteger&, const BigInteger&, std::size_t, BigInteger&);
+	void divide3n2n(const BigInteger&, const BigInteger&, const BigInteger&, const BigInteger&, std::size_t, BigInteger&);
+	void divideNewton(const BigInteger&, const BigInteger&, BigInteger&);
+	void reciprocal(const BigInteger&);
+
+	static BigInteger powerModulo(const BigInteger&, const BigInteger&, const BigInteger&, bool);
+
+	// gcd helpers on magnitudes a >= b, the rows are cofactor rows of width
+	// columns for a and then b, carried along through every step
+	static BigInteger fromWord(unsigned long long);
+	static void gcdReduce(BigInteger&, BigInteger&, BigInteger*);
+	static bool halfGcd(BigInteger&, BigInteger&, BigInteger*, std::size_t);
+	static void euclidStep(BigInteger&, BigInteger&, BigInteger*, std::size_t);
+	static void applyMatrix(const BigInteger*, BigInteger&, BigInteger&, BigInteger*, std::size_t);
+
+	// roots of positive values, rootEstimate() only for roots below Base;
+	// exact, when given, tells whether the root is exact
+	static BigInteger rootEstimate(const BigInteger&, unsigned int);
+	static BigInteger rootMagnitude(const BigInteger&, unsigned int, bool*);
+
+	// balanced product of count values, and of words packed with factors
+	static BigInteger productTree(const BigInteger*, std::size_t);
+	static BigInteger productOfWords(const std::vector<unsigned long long>&);
+
 	void karatsuba(const BigInteger&, const BigInteger&);
+	void toomCook3(const BigInteger&, const BigInteger&);
+	void multiplyUnbalanced(const BigInteger&, const BigInteger&);
+	void multiplyNTT(const BigInteger&, const BigInteger&);
+
+	void addMagnitude(const BigInteger&, const BigInteger&);
+	void subtractMagnitude(const BigInteger&, const BigInteger&);
+	void incrementMagnitude();
+	void decrementMagnitude();
+	void multiplyBySmall(BaseType);
+	BaseType divideBySmall(BaseType);
+	void assignLimbs(const BigInteger&, std::size_t, std::size_t);
+	void shiftLimbsLeft(std::size_t);
+	void shiftLimbsRight(std::size_t);
+
+	// text parsing, long binary inputs are split in halves recursively
+	void parse(const char*, std::size_t);
+	void parseMagnitude(const char*, std::size_t);
+	void parseDigits(const char*, std::size_t, const BigInteger* const*);
+	static const BigInteger& powerOfIOBase(std::size_t);
+
+	// convert the magnitude into little endian groups of IOBase
+	void toDecimalGroups(std::vector<BaseType>&) const;
+	// decimal digits for long values, zero padded to a power of two groups
+	void toDecimalDigits(std::vector<char>&) const;
+	static void writeDigits(const BigInteger&, std::size_t, const BigInteger* const*, char*);
 
 	Compare compare(const BigInteger&, const BigInteger&) const;
 	Compare compareMagnitude(const BigInteger&, const BigInteger&) const;
@@ -92,6 +687,158 @@ private:
 	bool isZero() const;
 
 	void removeTrailingZeros();
+
+	friend class BigIntegerView;
+	friend class ModContext;
+	friend class BigIntegerBatch;
 };
 
+// Read-only value over limbs owned elsewhere, a BigInteger or a serialized
+// buffer such as a mapped file. Nothing is copied, so the limbs have to stay
+// alive and unchanged while the view is in use. Comparisons, addition and
+// subtraction run on the limbs in place, multiplication and division too up
+// to the sizes where the schoolbook, karatsuba and knuth methods apply.
+class BigIntegerView
+{
+public:
+	BigIntegerView(const BigInteger&);
+	// the buffer must be in this build's limb kind with the limbs aligned for
+	// BaseType, only the header and the top limb are checked
+	BigIntegerView(const unsigned char*, std::size_t);
+
+	bool iszero() const;
+	std::size_t size() const;
+	const BigInteger::BaseType* data() const;
+
+	// returns -1, 0 or 1
+	int compare(const BigIntegerView&) const;
+
+	bool operator > (const BigIntegerView&) const;
+	bool operator == (const BigIntegerView&) const;
+	bool operator < (const BigIntegerView&) const;
+	bool operator >= (const BigIntegerView&) const;
+	bool operator != (const BigIntegerView&) const;
+	bool operator <= (const BigIntegerView&) const;
+
+	BigInteger operator + (const BigIntegerView&) const;
+	BigInteger operator - (const BigIntegerView&) const;
+	BigInteger operator * (const BigIntegerView&) const;
+	BigInteger operator / (const BigIntegerView&) const;
+	BigInteger operator % (const BigIntegerView&) const;
+
+private:
+	BigInteger::Sign sign;
+	const BigInteger::BaseType* limbs;
+	std::size_t count;
+
+	BigInteger combine(const BigIntegerView&, bool) const;
+	void divide(const BigIntegerView&, BigInteger*, BigInteger*) const;
+
+	friend class BigInteger;
+};
+
+// Repeated reduction by one modulus. The barrett reciprocal
+// floor(Base^2n / m) of an n limb modulus is computed once, after that a
+// reduction costs two multiplications per n limbs of input and no division.
+// Results lie in [0, |m|), the operands may be any values, negative or
+// longer than the modulus.
+class ModContext
+{
+public:
+	explicit ModContext(const BigInteger&);
+
+	const BigInteger& modulus() const;
+
+	BigInteger reduce(const BigInteger&) const;
+	BigInteger mulmod(const BigInteger&, const BigInteger&) const;
+	BigInteger addmod(const BigInteger&, const BigInteger&) const;
+	BigInteger submod(const BigInteger&, const BigInteger&) const;
+
+private:
+	BigInteger m;
+	BigInteger reciprocal;
+	std::size_t size;
+
+	void reduceInPlace(BigInteger&) const;
+	void barrettStep(BigInteger&) const;
+};
+
+// Many independent values of one size class in structure of arrays layout:
+// limb i of every value sits next to limb i of the others. Elementwise
+// operations then run across the values with one carry per lane and no
+// branch per value, the lane kernels use SIMD where the cpu has it. Every
+// value takes width() limbs. Results go into a batch owned by the caller,
+// its buffers are reused as long as they are large enough, and it may be
+// one of the operands.
+class BigIntegerBatch
+{
+public:
+	// pairs in the span functions whose longer value exceeds this many limbs
+	// skip the batches, the per value overhead doesn't matter for them
+	static const std::size_t MaxClassWidth = 64;
+
+	BigIntegerBatch();
+	// count zeros of width limbs
+	BigIntegerBatch(std::size_t, std::size_t);
+	// the values, as wide as the longest of them
+	BigIntegerBatch(const BigInteger*, std::size_t);
+
+	// count zeros of width limbs
+	void resize(std::size_t, std::size_t);
+	std::size_t size() const;
+	std::size_t width() const;
+
+	// set() throws for values longer than width(), get() reuses the
+	// storage of its output
+	void set(std::size_t, const BigInteger&);
+	void get(std::size_t, BigInteger&) const;
+	BigInteger operator [] (std::size_t) const;
+
+	// elementwise over two batches of the same size; sums are one limb
+	// wider than the wider operand, products as wide as both together;
+	// compare() writes -1, 0 or 1 per pair
+	static void add(const BigIntegerBatch&, const BigIntegerBatch&, BigIntegerBatch&);
+	static void subtract(const BigIntegerBatch&, const BigIntegerBatch&, BigIntegerBatch&);
+	static void multiply(const BigIntegerBatch&, const BigIntegerBatch&, BigIntegerBatch&);
+	static void compare(const BigIntegerBatch&, const BigIntegerBatch&, int*);
+
+	// elementwise over count pairs of any sizes, result[i] = lhs[i] op rhs[i].
+	// The pairs are sorted by size and run in batches of neighbours, so the
+	// values of a batch share their size class; result may be lhs or rhs.
+	// compare() goes pair by pair, without the batches.
+	static void add(const BigInteger*, const BigInteger*, BigInteger*, std::size_t);
+	static void subtract(const BigInteger*, const BigInteger*, BigInteger*, std::size_t);
+	static void multiply(const BigInteger*, const BigInteger*, BigInteger*, std::size_t);
+	static void compare(const BigInteger*, const BigInteger*, int*, std::size_t);
+
+private:
+	std::size_t count, columns;
+	// limb i of value j at limbs[i*count + j]
+	std::vector<BigInteger::BaseType> limbs;
+	std::vector<signed char> signs;
+
+	static void combine(const BigIntegerBatch&, const BigIntegerBatch&, BigIntegerBatch&, bool);
+	static void combineSpans(const BigInteger*, const BigInteger*, BigInteger*, std::size_t, int);
+};
+
+#ifdef BIGINTEGER_MAPPED_FILES
+// Read-only mapping of a file written by serialize(), the limbs are paged in
+// as they are touched instead of being loaded up front.
+class MappedBigInteger
+{
+public:
+	explicit MappedBigInteger(const std::string&);
+	~MappedBigInteger();
+
+	BigIntegerView view() const;
+
+private:
+	void* address;
+	std::size_t length;
+
+	MappedBigInteger(const MappedBigInteger&);
+	MappedBigInteger& operator = (const MappedBigInteger&);
+};
+#endif
+
 #endif